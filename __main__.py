@@ -3,16 +3,45 @@ import argparse
 import sys
 from viewer import *
 from image_loader import *
-import python_tools.iotools as ptio
-import glob
-import os
+from memory import format_bytes, parse_bytes
+from storage import STORAGES, convert_volume
+from loading import load_images, share_volume
+from stream import VolumeStream
+from derived import compile_expression
+
+
+def convert_storage(name, img, storage):
+    if img.dtype.kind != "f" or img.dtype.itemsize <= 2:
+        print(f"{name}: {img.dtype} volume kept as is, --storage applies to float volumes")
+        return img
+    compact, error = convert_volume(img, storage)
+    print(
+        f"{name}: {storage} storage {format_bytes(img.nbytes)} -> {format_bytes(compact.nbytes)}, "
+        f"quantization error max {error.max_error:.3g} rms {error.rms:.3g}"
+    )
+    return compact
 
-# TODO: remove dependency from python_tools
 
 def main():
-    parser = argparse.ArgumentParser(description='Plots a 3D volume')
+    if len(sys.argv) > 1 and sys.argv[1] == "export":
+        from export import main as export_main
+        sys.exit(export_main(sys.argv[2:]))
+
+    parser = argparse.ArgumentParser(description='Plots a 3D volume', epilog='Use "export" as first argument for headless batch export, see "export --help"')
     parser.add_argument('-i', '--image', metavar='i', type=str, nargs='+', help='filename of the image (if using DICOM, specify glob)')
-    parser.add_argument('-f', '--format', metavar='f', type=str, nargs='+', help='format of the volume (dicom, f32, f64, nii, npy)')
+    parser.add_argument('-f', '--format', metavar='f', type=str, nargs='+', help='format of the volume (dicom, f32, f64, nii, npy, stream); raw f32 and f64 files may give their shape, f32:NZxNYxNX, to be memory-mapped (needed by --crop and --bin); nii and npy may be 4D time series; stream reads slices as a producer writes them to stdin (-i -) or a Unix socket (-i unix:PATH)')
+    parser.add_argument('-s', '--spacing', metavar='s', type=str, nargs='+', help='voxel spacing "sx,sy,sz" of each image, for formats without geometry metadata')
+    parser.add_argument('--overlay', metavar=('BASE', 'OVERLAY'), type=int, nargs=2, action='append', help='fuse image OVERLAY on top of the viewer of image BASE (0-based indices, not with --triplanar)')
+    parser.add_argument('--compare', metavar=('A', 'B'), type=int, nargs=2, action='append', help='open a derived viewer comparing images A and B (0-based indices)')
+    parser.add_argument('--compare-mode', type=str, default='difference', choices=['difference', 'ratio', 'abserror'], help='comparison computed by --compare viewers')
+    parser.add_argument('-e', '--expr', metavar='EXPR', type=str, action='append', help='open a derived viewer on an expression of the images, named a, b, c, ... in order (e.g. "(a - b) / (b + 1e-3)")')
+    parser.add_argument('--triplanar', action='store_true', help='show each volume as linked XY, XZ and YZ panes')
+    parser.add_argument('--storage', type=str, choices=STORAGES, help='keep volumes in memory as float16 (f16) or as uint16 with a slope and intercept (u16q)')
+    parser.add_argument('--render-processes', action='store_true', help='render each viewer in its own process, over volumes placed once in shared memory')
+    parser.add_argument('--watch', action='store_true', help='reload images when their file is rewritten, e.g. by a running reconstruction (watched images are kept in memory)')
+    parser.add_argument('--crop', type=parse_crop, metavar='z0:z1,y0:y1,x0:x1', help='load only this voxel region of every file image (empty bounds keep the whole axis); npy stays memory-mapped, sitk/nii formats read the region only when their reader streams')
+    parser.add_argument('--bin', type=int, default=1, metavar='N', help='average NxNxN voxel blocks while loading, so only the binned volume is kept in memory')
+    parser.add_argument('--memory-budget', type=parse_bytes, help='memory budget of volumes and caches, e.g. 8G (default: half of the RAM)')
 
     args = parser.parse_args()
     
@@ -30,33 +59,65 @@ def main():
         exit()
     
     
-    images = []
+    if args.spacing is not None and len(args.spacing) != len(args.image):
+        print("Error: Use the same number of spacings as the number of images given")
+        exit()
+    if args.bin < 1:
+        print("Error: --bin must be at least 1")
+        exit()
+
+    if args.triplanar and args.overlay:
+        print("Error: --overlay fuses images in the single-plane viewer, it cannot be used with --triplanar")
+        exit()
+
+    # Derived viewers open from a Qt slot once images are loaded, check them now
+    for flag, pairs in (("--overlay", args.overlay), ("--compare", args.compare)):
+        for pair in pairs or []:
+            if not all(0 <= i < len(args.image) for i in pair):
+                print(f"Error: {flag} {pair[0]} {pair[1]} refers to an image that was not given (0 to {len(args.image) - 1})")
+                exit()
+    for n, expression in enumerate(args.expr or []):
+        # Named after the images, then the --compare viewers and earlier expressions
+        count = min(len(args.image) + len(args.compare or []) + n, 26)
+        try:
+            _, names = compile_expression(expression)
+        except ValueError as e:
+            print(f"Error: {e}")
+            exit()
+        unknown = [v for v in names if len(v) != 1 or not 0 <= ord(v) - ord("a") < count]
+        if unknown:
+            print(f"Error: {unknown} in {expression!r} name no volume, use a to {chr(ord('a') + count - 1)}")
+            exit()
+
+    # Loaded concurrently, each viewer opens as soon as its volume is ready
+    specs = [
+        (args.image[i], args.format[i], args.spacing[i] if args.spacing is not None else None, args.crop, args.bin)
+        for i in range(len(args.format))
+    ]
+    def postprocess(i, img):
+        if args.storage is not None:
+            img = convert_storage(args.image[i], img, args.storage)
+        if args.watch and getattr(img, "flags", None) is not None and not (img.flags.writeable and img.flags.c_contiguous):
+            img = np.array(img, order="C")  # Refreshed in place through its flat slices
+        if args.render_processes:
+            img = share_volume(img)[0]  # Moved once, while the loader owns it
+        return img
 
-    num_imgs = len(args.format)
-    for i in range(num_imgs):
-        if args.format[i] == "f32":
-            img = ptio.DataFileRawd().load(args.image[i], dtype=np.float32)
-        elif args.format[i] == "f64":
-            img = ptio.DataFileRawd().load(args.image[i], dtype=np.float64)
-        elif args.format[i] == "dicom" or args.format[i] == "dcm":
-            slices = []
-            sorted_glob = sorted(glob.glob(args.image[i]))
-            for file_path in sorted_glob:
-                if os.path.isfile(file_path):
-                    slices.append(ptio.DataFileDicom().load(file_path))
-            img = np.stack(slices, axis=0)
-        elif args.format[i] == "sitk" or args.format[i] == "nii":
-            img = ptio.DataFileSITK().load(args.image[i])
-            if(len(img.shape) > 3):
-                img = np.squeeze(img)
-        elif args.format[i] == "npy" or args.format[i] == "np":
-            img = ptio.DataFileNumpy().load(args.image[i])
-            if(len(img.shape) > 3):
-                img = np.squeeze(img)
-        
-        images.append(img)
+    # Streams open their viewer on their header, then fill it slice by slice
+    streams = {
+        i: VolumeStream(spec[0], shared=args.render_processes)
+        for i, spec in enumerate(specs)
+        if spec[1] == "stream"
+    }
+    files = [i for i in range(len(specs)) if i not in streams]
+    loads = iter(load_images([specs[i] for i in files], lambda j, img: postprocess(files[j], img)))
+    images = [streams[i].ready if i in streams else next(loads) for i in range(len(specs))]
+    watch = [None if i in streams else spec for i, spec in enumerate(specs)]
+    options = {"storage": args.storage, "crop": args.crop, "bin": args.bin}
+    sources = [None if i in streams else (spec[0], options) for i, spec in enumerate(specs)]
 
-    manager = VolumeViewerManager(images)
+    comparisons = [(a, b, args.compare_mode) for a, b in args.compare or []]
+    manager = VolumeViewerManager(images, triplanar=args.triplanar, overlays=args.overlay, comparisons=comparisons, expressions=args.expr, memory_budget=args.memory_budget, render_processes=args.render_processes, watch=watch if args.watch else None, streams=streams, sources=sources)
     sys.exit(manager.app.exec_())
 
 
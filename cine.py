@@ -0,0 +1,135 @@
+#!/usr/bin/env python
+import time
+from collections import OrderedDict, deque
+from concurrent.futures import ThreadPoolExecutor
+from PyQt5.QtCore import QObject, QTimer, Qt, pyqtSignal
+
+
+class CinePlayer(QObject):
+    """Plays frames at a target rate from a ring buffer filled by workers
+
+    make_job(index) is called on the GUI thread and returns a callable that
+    renders that frame; the callable runs in a worker thread, so it must only
+    use state captured when it was made. Up to buffer_size frames ahead of the
+    playhead are kept in flight. When a frame is not ready at its deadline it
+    is dropped and playback moves on, so the pace holds under load.
+
+    A player started with paced=False has no timer of its own: it prefetches
+    the same way but is driven by take(), e.g. by a synced viewer's player.
+    """
+
+    frame_ready = pyqtSignal(int, object)  # (index, rendered frame)
+    stats_changed = pyqtSignal(float, int)  # (achieved fps, dropped frames)
+    failed = pyqtSignal(str)  # A frame job raised, playback has stopped
+
+    def __init__(self, make_job, num_frames, fps=10.0, buffer_size=8, workers=2):
+        super().__init__()
+        self.make_job = make_job
+        self.num_frames = num_frames
+        self.fps = fps
+        self.buffer_size = buffer_size
+        self.executor = ThreadPoolExecutor(max_workers=workers)
+        self.ring = OrderedDict()  # index -> Future, in playback order
+        self.position = 0
+        self.following = False
+        self.dropped = 0
+        self.shown_times = deque(maxlen=120)
+
+        self.timer = QTimer(self)
+        self.timer.setTimerType(Qt.PreciseTimer)
+        self.timer.timeout.connect(self._tick)
+
+    def is_playing(self):
+        return self.timer.isActive() or self.following
+
+    def start(self, position=0, paced=True):
+        self.position = position
+        self.dropped = 0
+        self.shown_times.clear()
+        self.flush()
+        self._fill()
+        self.following = not paced
+        if paced:
+            self.timer.start(max(1, int(round(1000 / self.fps))))
+
+    def stop(self):
+        self.timer.stop()
+        self.following = False
+        self.flush()
+
+    def set_num_frames(self, num_frames):
+        self.stop()
+        self.num_frames = num_frames
+
+    def set_fps(self, fps):
+        self.fps = fps
+        if self.is_playing():
+            self.timer.setInterval(max(1, int(round(1000 / fps))))
+
+    def flush(self):
+        """Discard buffered frames, e.g. after the render parameters changed"""
+        for future in self.ring.values():
+            future.cancel()
+        self.ring.clear()
+
+    def achieved_fps(self):
+        if len(self.shown_times) < 2:
+            return 0.0
+        span = self.shown_times[-1] - self.shown_times[0]
+        return (len(self.shown_times) - 1) / span if span > 0 else 0.0
+
+    def _next(self, index):
+        return (index + 1) % self.num_frames
+
+    def _fill(self):
+        """Keep buffer_size upcoming frames queued in the worker pool"""
+        upcoming = []
+        index = self._next(self.position)
+        for _ in range(min(self.buffer_size, self.num_frames)):
+            upcoming.append(index)
+            index = self._next(index)
+
+        # Frames the playhead moved past (e.g. after a jump) are abandoned
+        for index in [i for i in self.ring if i not in upcoming]:
+            self.ring.pop(index).cancel()
+        for index in upcoming:
+            if index not in self.ring:
+                self.ring[index] = self.executor.submit(self.make_job(index))
+
+    def _take(self, index):
+        """Pop a buffered frame, None (counted as dropped) if it is not ready"""
+        future = self.ring.pop(index, None)
+        self.position = index
+        result = None
+        if future is not None and future.done() and not future.cancelled():
+            try:
+                result = future.result()
+            except Exception as error:
+                # Re-raised in a Qt slot, it would abort the process
+                self.stop()
+                self.failed.emit(f"{type(error).__name__}: {error}")
+                return None
+            self.shown_times.append(time.perf_counter())
+        else:
+            if future is not None:
+                future.cancel()
+            self.dropped += 1
+        self._fill()
+        self.stats_changed.emit(self.achieved_fps(), self.dropped)
+        return result
+
+    def take(self, index):
+        """Frame prefetched for index when driven externally (paced=False)"""
+        if not self.following:
+            return None
+        return self._take(index)
+
+    def _tick(self):
+        index = self._next(self.position)
+        result = self._take(index)
+        if result is not None:
+            self.frame_ready.emit(index, result)
+
+    def shutdown(self):
+        self.stop()
+        self.executor.shutdown(wait=False)
@@ -0,0 +1,240 @@
+#!/usr/bin/env python
+import ast
+import threading
+import time
+from collections import OrderedDict
+import numpy as np
+
+try:
+    import numexpr
+except ImportError:
+    numexpr = None
+
+LAZY_SAMPLE_VOXELS = 1_000_000  # Voxels read to estimate the range of a lazy volume
+EXPRESSION_BLOCK_VOXELS = 1 << 16  # Block size of the numpy evaluation, cache-sized
+EXPRESSION_CACHE_BYTES = 64 << 20  # Budget of the per-expression region cache
+
+# Comparison mode -> expression of two volumes a and b
+COMPARISONS = {
+    "difference": "a - b",
+    "ratio": "where(b != 0, a / b, 0)",
+    "abserror": "abs(a - b)",
+}
+
+# Functions usable in expressions, shared by numexpr and numpy
+_FUNCTIONS = {
+    "abs": np.abs,
+    "sqrt": np.sqrt,
+    "exp": np.exp,
+    "log": np.log,
+    "where": np.where,
+}
+
+_ALLOWED_NODES = (
+    ast.Expression,
+    ast.BinOp,
+    ast.UnaryOp,
+    ast.Compare,
+    ast.Call,
+    ast.Name,
+    ast.Load,
+    ast.Constant,
+    ast.Add,
+    ast.Sub,
+    ast.Mult,
+    ast.Div,
+    ast.Pow,
+    ast.USub,
+    ast.UAdd,
+    ast.Lt,
+    ast.LtE,
+    ast.Gt,
+    ast.GtE,
+    ast.Eq,
+    ast.NotEq,
+)
+
+
+class DerivedVolume:
+    """Read-only volume computed from other volumes only where it is indexed
+
+    Indexing with a key reads that same key from every input and combines
+    the regions, so a viewer displaying a zoomed slice only computes the
+    visible voxels. Nothing is materialized for the whole volume.
+    """
+
+    lazy = True
+
+    def __init__(self, inputs, function, dtype=np.float32):
+        shapes = {tuple(v.shape) for v in inputs}
+        if len(shapes) != 1:
+            raise ValueError(
+                f"Derived volumes need inputs of identical shapes, got {sorted(shapes)}"
+            )
+        self.inputs = list(inputs)
+        self.function = function
+        self.shape = shapes.pop()
+        self.ndim = len(self.shape)
+        self.dtype = np.dtype(dtype)
+
+    def __len__(self):
+        return self.shape[0]
+
+    def __getitem__(self, key):
+        regions = [np.asarray(v[key], dtype=np.float32) for v in self.inputs]
+        return self.function(*regions)
+
+    def estimate_range(self):
+        """(min, max) over a strided subsample, the full volume is never computed"""
+        step = max(1, int(round((np.prod(self.shape) / LAZY_SAMPLE_VOXELS) ** (1 / 3))))
+        sample = self[tuple(slice(None, None, step) for _ in self.shape)]
+        return [float(np.nanmin(sample)), float(np.nanmax(sample))]
+
+
+def parse_expression(expression):
+    """Validate an elementwise expression, returning (tree, variable names)"""
+    try:
+        tree = ast.parse(expression, mode="eval")
+    except SyntaxError as e:
+        raise ValueError(f"Invalid expression {expression!r}: {e.msg}")
+
+    names = []
+    for node in ast.walk(tree):
+        if not isinstance(node, _ALLOWED_NODES):
+            raise ValueError(
+                f"Unsupported syntax in expression {expression!r}: {type(node).__name__}"
+            )
+        if isinstance(node, ast.Call):
+            if not isinstance(node.func, ast.Name) or node.func.id not in _FUNCTIONS:
+                raise ValueError(f"Unknown function in expression {expression!r}")
+        elif isinstance(node, ast.Constant) and not isinstance(node.value, (int, float)):
+            raise ValueError(f"Only numeric constants are allowed in {expression!r}")
+        elif isinstance(node, ast.Name) and node.id not in _FUNCTIONS:
+            if node.id not in names:
+                names.append(node.id)
+    if not names:
+        raise ValueError(f"Expression {expression!r} references no volume")
+    return tree, names
+
+
+def compile_expression(expression):
+    """Compile an expression once into a kernel taking its variables in order
+
+    With numexpr the whole expression runs as one fused, multi-threaded
+    loop. Otherwise the compiled numpy code is evaluated block by block so
+    its temporaries stay cache-sized.
+    """
+    tree, names = parse_expression(expression)
+
+    if numexpr is not None:
+        source = ast.unparse(tree)
+
+        def kernel(*regions):
+            result = numexpr.evaluate(source, local_dict=dict(zip(names, regions)))
+            return np.asarray(result, dtype=np.float32)
+
+        return kernel, names
+
+    code = compile(tree, "<expression>", "eval")
+    namespace = {"__builtins__": {}, **_FUNCTIONS}
+
+    def kernel(*regions):
+        shape = np.broadcast_shapes(*(r.shape for r in regions))
+        flat = [np.broadcast_to(r, shape).reshape(-1) for r in regions]
+        out = np.empty(int(np.prod(shape)), dtype=np.float32)
+        with np.errstate(divide="ignore", invalid="ignore"):
+            for start in range(0, out.size, EXPRESSION_BLOCK_VOXELS):
+                block = slice(start, start + EXPRESSION_BLOCK_VOXELS)
+                variables = {n: r[block] for n, r in zip(names, flat)}
+                out[block] = eval(code, namespace, variables)
+        return out.reshape(shape)
+
+    return kernel, names
+
+
+def _hashable_key(key):
+    """Hashable form of an indexing key, or None for fancy indexing"""
+    if not isinstance(key, tuple):
+        key = (key,)
+    parts = []
+    for k in key:
+        if isinstance(k, slice):
+            parts.append(("s", k.start, k.stop, k.step))
+        elif isinstance(k, (int, np.integer)):
+            parts.append(int(k))
+        else:
+            return None
+    return tuple(parts)
+
+
+class ExpressionVolume(DerivedVolume):
+    """Volume defined by an expression such as "(a - b) / (b + 1e-3)"
+
+    Variables are looked up by name in the given mapping of volumes. The
+    expression is parsed and compiled once; evaluated regions are kept in a
+    small LRU cache so repainting the same view costs nothing, while memory
+    stays bounded to roughly what is on screen. Worker threads (cine, block
+    tables) index the volume too, the cache is guarded by a lock.
+    """
+
+    def __init__(self, expression, volumes, cache_bytes=EXPRESSION_CACHE_BYTES):
+        kernel, names = compile_expression(expression)
+        missing = [n for n in names if n not in volumes]
+        if missing:
+            raise ValueError(f"Unknown volume(s) {missing} in expression {expression!r}")
+        super().__init__([volumes[n] for n in names], kernel)
+        self.expression = expression
+        self.names = names
+        self.cache_bytes = cache_bytes
+        self._cache = OrderedDict()
+        self._cached_bytes = 0
+        self._lock = threading.Lock()
+        self.last_used = time.monotonic()
+        self.governor = None  # MemoryGovernor, see memory.py
+
+    @property
+    def nbytes(self):
+        """Bytes held by the region cache, the volume itself holds none"""
+        return self._cached_bytes
+
+    def __getitem__(self, key):
+        self.last_used = time.monotonic()
+        cache_key = _hashable_key(key)
+        if cache_key is not None:
+            with self._lock:
+                cached = self._cache.get(cache_key)
+                if cached is not None:
+                    self._cache.move_to_end(cache_key)
+                    return cached
+
+        # Computed outside of the lock, so threads evaluate regions concurrently
+        result = super().__getitem__(key)
+        if cache_key is not None and result.nbytes <= self.cache_bytes:
+            result.setflags(write=False)
+            with self._lock:
+                if cache_key not in self._cache:
+                    self._cache[cache_key] = result
+                    self._cached_bytes += result.nbytes
+                while self._cached_bytes > self.cache_bytes:
+                    _, dropped = self._cache.popitem(last=False)
+                    self._cached_bytes -= dropped.nbytes
+        return result
+
+    def invalidate(self):
+        with self._lock:
+            self._cache.clear()
+            self._cached_bytes = 0
+
+    def evict(self, nbytes):
+        """Drop least recently used regions until nbytes are freed, return bytes freed"""
+        freed = 0
+        with self._lock:
+            while self._cache and freed < nbytes:
+                freed += self._cache.popitem(last=False)[1].nbytes
+            self._cached_bytes -= freed
+        return freed
+
+
+def compare_volumes(a, b, mode="difference"):
+    """Lazy difference, ratio or absolute error of two volumes"""
+    return ExpressionVolume(COMPARISONS[mode], {"a": a, "b": b})
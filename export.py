@@ -0,0 +1,306 @@
+#!/usr/bin/env python
+import argparse
+import multiprocessing
+import os
+import struct
+import time
+import zlib
+import numpy as np
+from image_loader import load_image, parse_crop
+from geometry import ImageGeometry, fit_to_canvas
+from rendering import (
+    COLORMAPS,
+    INTERPOLATIONS,
+    extract_slice,
+    indices_to_rgb,
+    num_frames,
+    num_slices,
+    render_rgb,
+    resample_slice,
+    volume_range,
+    window_to_uint8,
+)
+
+ORIENTATIONS = {"xy": 0, "xz": 1, "yz": 2}
+
+
+def write_png(path, rgb):
+    """Write an (h, w, 3) uint8 image as an 8-bit RGB PNG"""
+    h, w = rgb.shape[:2]
+    # Each scanline is prefixed by its filter type, 0 (none)
+    raw = np.zeros((h, w * 3 + 1), dtype=np.uint8)
+    raw[:, 1:] = rgb.reshape(h, w * 3)
+
+    def chunk(kind, data):
+        body = kind + data
+        return struct.pack(">I", len(data)) + body + struct.pack(">I", zlib.crc32(body))
+
+    with open(path, "wb") as f:
+        f.write(b"\x89PNG\r\n\x1a\n")
+        f.write(chunk(b"IHDR", struct.pack(">IIBBBBB", w, h, 8, 2, 0, 0, 0)))
+        f.write(chunk(b"IDAT", zlib.compress(raw.tobytes(), 6)))
+        f.write(chunk(b"IEND", b""))
+
+
+def write_tiff(path, rgb):
+    """Write an (h, w, 3) uint8 image as an uncompressed baseline RGB TIFF"""
+    h, w = rgb.shape[:2]
+    data = np.ascontiguousarray(rgb, dtype=np.uint8).tobytes()
+    data += b"\0" * (len(data) % 2)  # The IFD must start on a word boundary
+    bits_offset = 8 + len(data)
+    bits = struct.pack("<3H", 8, 8, 8) + b"\0\0"
+    ifd_offset = bits_offset + len(bits)
+
+    short, long = 3, 4
+    entries = [
+        (256, long, 1, w),  # ImageWidth
+        (257, long, 1, h),  # ImageLength
+        (258, short, 3, bits_offset),  # BitsPerSample, stored at an offset
+        (259, short, 1, 1),  # Compression: none
+        (262, short, 1, 2),  # PhotometricInterpretation: RGB
+        (273, long, 1, 8),  # StripOffsets
+        (277, short, 1, 3),  # SamplesPerPixel
+        (278, long, 1, h),  # RowsPerStrip
+        (279, long, 1, w * h * 3),  # StripByteCounts
+        (284, short, 1, 1),  # PlanarConfiguration: chunky
+    ]
+    ifd = struct.pack("<H", len(entries))
+    for tag, kind, count, value in entries:
+        if kind == short and count == 1:
+            ifd += struct.pack("<HHIHH", tag, kind, count, value, 0)
+        else:
+            ifd += struct.pack("<HHII", tag, kind, count, value)
+    ifd += struct.pack("<I", 0)
+
+    with open(path, "wb") as f:
+        f.write(b"II" + struct.pack("<HI", 42, ifd_offset))
+        f.write(data)
+        f.write(bits)
+        f.write(ifd)
+
+
+WRITERS = {"png": write_png, "tiff": write_tiff}
+
+
+class ExportJob:
+    """Everything the viewer's render pipeline needs, minus the widgets"""
+
+    def __init__(
+        self,
+        volume,
+        geometry,
+        orientation=0,
+        frame=0,
+        view_rect=None,
+        size=None,
+        window_level=None,
+        colormap="gray",
+        method="nearest",
+    ):
+        self.volume = volume
+        self.geometry = geometry or ImageGeometry()
+        self.orientation = orientation
+        self.frame = frame
+        h, w = extract_slice(volume, orientation, 0, frame).shape
+        self.view_rect = tuple(view_rect) if view_rect is not None else (0, w, 0, h)
+        self.window_level = window_level or volume_range(volume)
+        self.colormap = colormap
+        self.method = method
+
+        # Same sizing as the viewer: physical aspect, fit into the requested
+        # canvas, by default one pixel per smallest voxel spacing
+        x_min, x_max, y_min, y_max = self.view_rect
+        spacing = self.geometry.plane_spacing(orientation)
+        if size is None:
+            size = (
+                (x_max - x_min) * spacing[0] / min(spacing),
+                (y_max - y_min) * spacing[1] / min(spacing),
+            )
+        self.out_w, self.out_h = fit_to_canvas(
+            x_max - x_min, y_max - y_min, spacing, *size
+        )
+
+    def render(self, index):
+        slice_data = extract_slice(self.volume, self.orientation, index, self.frame)
+        return render_rgb(
+            slice_data,
+            self.view_rect,
+            self.out_w,
+            self.out_h,
+            self.window_level,
+            self.colormap,
+            self.method,
+        )
+
+    def visible_bounds(self):
+        """Integer (row0, row1, col0, col1) of the input read by the view"""
+        x_min, x_max, y_min, y_max = self.view_rect
+        h, w = extract_slice(self.volume, self.orientation, 0, self.frame).shape
+        return (
+            max(int(np.floor(y_min)) - 3, 0),
+            min(int(np.ceil(y_max)) + 3, h),
+            max(int(np.floor(x_min)) - 3, 0),
+            min(int(np.ceil(x_max)) + 3, w),
+        )
+
+
+# Job of the worker processes. Set through the pool initializer, which a
+# forked pool inherits without pickling, so the volume is shared not copied.
+_JOB = None
+
+
+def _init_worker(job):
+    global _JOB
+    _JOB = job
+
+
+def _export_slices(tasks):
+    for index, path, writer in tasks:
+        WRITERS[writer](path, _JOB.render(index))
+    return len(tasks)
+
+
+def _render_tiles(indices):
+    return [(index, _JOB.render(index)) for index in indices]
+
+
+def _max_projection(indices):
+    """Max of the visible region over a run of slices (one partial reduction)"""
+    r0, r1, c0, c1 = _JOB.visible_bounds()
+    result = None
+    for index in indices:
+        region = extract_slice(_JOB.volume, _JOB.orientation, index, _JOB.frame)
+        region = np.asarray(region[r0:r1, c0:c1])
+        result = region.copy() if result is None else np.maximum(result, region, out=result)
+    return result
+
+
+def _chunks(items, workers):
+    """Split work into a few chunks per worker to balance the load"""
+    size = max(1, len(items) // (workers * 4))
+    return [items[i : i + size] for i in range(0, len(items), size)]
+
+
+def _pool(job, workers):
+    methods = multiprocessing.get_all_start_methods()
+    context = multiprocessing.get_context("fork" if "fork" in methods else None)
+    return context.Pool(workers, initializer=_init_worker, initargs=(job,))
+
+
+def export_slices(job, indices, output, writer="png", workers=None):
+    workers = workers or os.cpu_count()
+    tasks = [(i, f"{output}_{i:04d}.{writer}", writer) for i in indices]
+    with _pool(job, workers) as pool:
+        return sum(pool.imap_unordered(_export_slices, _chunks(tasks, workers)))
+
+
+def export_mip(job, indices, output, writer="png", workers=None):
+    """Maximum intensity projection along the slice axis, rendered like a slice"""
+    workers = workers or os.cpu_count()
+    with _pool(job, workers) as pool:
+        partials = pool.map(_max_projection, _chunks(list(indices), workers))
+    projection = np.maximum.reduce(partials)
+
+    r0, _, c0, _ = job.visible_bounds()
+    x_min, x_max, y_min, y_max = job.view_rect
+    view_rect = (x_min - c0, x_max - c0, y_min - r0, y_max - r0)
+    frame = resample_slice(projection, view_rect, job.out_w, job.out_h, job.method)
+    rgb = indices_to_rgb(window_to_uint8(frame, *job.window_level), job.colormap)
+    WRITERS[writer](f"{output}.{writer}", rgb)
+    return 1
+
+
+def export_montage(job, indices, output, columns, writer="png", workers=None):
+    """Grid of the rendered slices, row by row"""
+    workers = workers or os.cpu_count()
+    indices = list(indices)
+    rows = (len(indices) + columns - 1) // columns
+    montage = np.zeros((rows * job.out_h, columns * job.out_w, 3), dtype=np.uint8)
+    position = {index: n for n, index in enumerate(indices)}
+    with _pool(job, workers) as pool:
+        for tiles in pool.imap_unordered(_render_tiles, _chunks(indices, workers)):
+            for index, rgb in tiles:
+                row, column = divmod(position[index], columns)
+                montage[
+                    row * job.out_h : (row + 1) * job.out_h,
+                    column * job.out_w : (column + 1) * job.out_w,
+                ] = rgb
+    WRITERS[writer](f"{output}.{writer}", montage)
+    return 1
+
+
+def _floats(text, count, name):
+    values = [float(v) for v in text.split(",")]
+    if len(values) != count:
+        raise argparse.ArgumentTypeError(f"{name} needs {count} comma separated values")
+    return values
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(
+        prog="interdit export",
+        description="Render slices, projections or montages without any window",
+    )
+    parser.add_argument('-i', '--image', type=str, required=True, help='filename of the image (if using DICOM, specify glob)')
+    parser.add_argument('-f', '--format', type=str, default='sitk', help='format of the volume (dicom, f32, f64, nii, npy), f32:NZxNYxNX memory-maps a raw file of that shape')
+    parser.add_argument('-s', '--spacing', type=str, help='voxel spacing "sx,sy,sz", for formats without geometry metadata')
+    parser.add_argument('--crop', type=parse_crop, metavar='z0:z1,y0:y1,x0:x1', help='load only this voxel region (empty bounds keep the whole axis)')
+    parser.add_argument('--bin', type=int, default=1, metavar='N', help='average NxNxN voxel blocks while loading')
+    parser.add_argument('-o', '--output', type=str, required=True, help='output path prefix, slices are written as PREFIX_0000.png, ...')
+    parser.add_argument('--mode', type=str, default='slices', choices=['slices', 'mip', 'montage'], help='what to export')
+    parser.add_argument('--orientation', type=str, default='xy', choices=list(ORIENTATIONS), help='slicing orientation')
+    parser.add_argument('--slices', type=str, help='slice range start:stop[:step] (default: all)')
+    parser.add_argument('--frame', type=int, default=0, help='time frame of a 4D series')
+    parser.add_argument('--view', type=str, help='view rect "x_min,x_max,y_min,y_max" in slice coordinates')
+    parser.add_argument('--window', type=str, help='window level "min,max" (default: volume range)')
+    parser.add_argument('--colormap', type=str, default='gray', choices=list(COLORMAPS))
+    parser.add_argument('--interp', type=str, default='nearest', choices=list(INTERPOLATIONS))
+    parser.add_argument('--size', type=str, help='maximum output size "WxH" (default: native resolution)')
+    parser.add_argument('--columns', type=int, default=6, help='montage columns')
+    parser.add_argument('--image-format', type=str, default='png', choices=list(WRITERS))
+    parser.add_argument('-j', '--jobs', type=int, default=os.cpu_count(), help='worker processes')
+    args = parser.parse_args(argv)
+
+    if args.bin < 1:
+        parser.error("--bin must be at least 1")
+    volume, geometry = load_image(args.image, args.format, args.spacing, args.crop, args.bin)
+    orientation = ORIENTATIONS[args.orientation]
+    if not 0 <= args.frame < num_frames(volume):
+        parser.error(f"--frame must be within [0, {num_frames(volume)})")
+
+    job = ExportJob(
+        volume,
+        geometry,
+        orientation=orientation,
+        frame=args.frame,
+        view_rect=_floats(args.view, 4, "--view") if args.view else None,
+        size=[float(v) for v in args.size.lower().split("x")] if args.size else None,
+        window_level=_floats(args.window, 2, "--window") if args.window else None,
+        colormap=args.colormap,
+        method=args.interp,
+    )
+    count = num_slices(volume, orientation)
+    if args.slices:
+        indices = range(count)[slice(*[int(v) if v else None for v in args.slices.split(":")])]
+    else:
+        indices = range(count)
+    if len(indices) == 0:
+        parser.error("--slices selects no slice")
+
+    output_dir = os.path.dirname(args.output)
+    if output_dir:
+        os.makedirs(output_dir, exist_ok=True)
+
+    start = time.perf_counter()
+    if args.mode == "slices":
+        written = export_slices(job, list(indices), args.output, args.image_format, args.jobs)
+    elif args.mode == "mip":
+        written = export_mip(job, indices, args.output, args.image_format, args.jobs)
+    else:
+        written = export_montage(job, indices, args.output, args.columns, args.image_format, args.jobs)
+    elapsed = time.perf_counter() - start
+    print(
+        f"Exported {written} image(s) of {job.out_w}x{job.out_h} from {len(indices)} "
+        f"slice(s) with {args.jobs} worker(s) in {elapsed:.2f} s"
+    )
+    return 0
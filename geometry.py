@@ -0,0 +1,82 @@
+#!/usr/bin/env python
+import numpy as np
+
+# For each orientation: (column axis, row axis, slice axis) as x=0, y=1, z=2
+PLANE_AXES = {0: (0, 1, 2), 1: (0, 2, 1), 2: (1, 2, 0)}
+
+
+class ImageGeometry:
+    """Voxel spacing, origin and direction of a volume
+
+    All vectors are in XYZ order even though the arrays are stored ZYX.
+    Continuous indices put voxel centers on integers, so physical position
+    is origin + direction @ (spacing * index).
+    """
+
+    def __init__(self, spacing=None, origin=None, direction=None):
+        self.is_default = spacing is None and origin is None and direction is None
+        self.spacing = np.asarray(spacing if spacing is not None else (1, 1, 1), float)
+        self.origin = np.asarray(origin if origin is not None else (0, 0, 0), float)
+        self.direction = np.asarray(
+            direction if direction is not None else np.eye(3), float
+        ).reshape(3, 3)
+
+        self.index_to_physical = np.eye(4)
+        self.index_to_physical[:3, :3] = self.direction * self.spacing
+        self.index_to_physical[:3, 3] = self.origin
+        self.physical_to_index = np.linalg.inv(self.index_to_physical)
+
+    @classmethod
+    def from_sitk(cls, image):
+        """Geometry of a SimpleITK image (extra dimensions are dropped)"""
+        dim = image.GetDimension()
+        direction = np.asarray(image.GetDirection()).reshape(dim, dim)[:3, :3]
+        return cls(image.GetSpacing()[:3], image.GetOrigin()[:3], direction)
+
+    def cropped(self, start_xyz, bin=1):
+        """Geometry of the grid of bin^3 voxel blocks starting at an XYZ index
+
+        Blocks are centered between the voxels they average.
+        """
+        corner = np.asarray(start_xyz, float) + (bin - 1) / 2
+        return ImageGeometry(self.spacing * bin, self.to_physical(corner), self.direction)
+
+    def to_physical(self, index_xyz):
+        return self.index_to_physical[:3, :3] @ index_xyz + self.index_to_physical[:3, 3]
+
+    def to_index(self, physical_xyz):
+        return self.physical_to_index[:3, :3] @ physical_xyz + self.physical_to_index[:3, 3]
+
+    def plane_spacing(self, orientation):
+        """(column spacing, row spacing) of slices in the given orientation"""
+        column_axis, row_axis, _ = PLANE_AXES[orientation]
+        return self.spacing[column_axis], self.spacing[row_axis]
+
+    def __repr__(self):
+        return (
+            f"ImageGeometry(spacing={tuple(self.spacing)}, "
+            f"origin={tuple(self.origin)})"
+        )
+
+
+def index_transform(source, target):
+    """Affine mapping continuous indices of source onto those of target"""
+    return target.physical_to_index @ source.index_to_physical
+
+
+def plane_point(orientation, column, row, slice_index):
+    """XYZ index of an in-plane (column, row) position on a slice"""
+    point = np.empty(3)
+    column_axis, row_axis, slice_axis = PLANE_AXES[orientation]
+    point[column_axis] = column
+    point[row_axis] = row
+    point[slice_axis] = slice_index
+    return point
+
+
+def fit_to_canvas(view_w, view_h, spacing, canvas_w, canvas_h):
+    """Largest output size showing a view with the right physical aspect"""
+    phys_w = view_w * spacing[0]
+    phys_h = view_h * spacing[1]
+    scale = min(canvas_w / phys_w, canvas_h / phys_h)
+    return max(1, int(round(phys_w * scale))), max(1, int(round(phys_h * scale)))
@@ -0,0 +1,100 @@
+#!/usr/bin/env python
+import os
+from concurrent.futures import ThreadPoolExecutor
+import numpy as np
+from rendering import frame_volume
+
+HOTSPOT_PEAKS = 1  # Peaks found by default
+HOTSPOT_RADIUS = 5  # Peaks are local maxima within this many voxels, 0 disables
+
+
+def _clip_box(box, shape):
+    return [(max(0, min(int(a), n)), max(0, min(int(b), n))) for (a, b), n in zip(box, shape)]
+
+
+def _slice_max(plane, suppressed):
+    """(max, (y, x)) of a 2D region with suppressed boxes and NaN excluded"""
+    plane = np.array(plane, dtype=np.float32)
+    plane[np.isnan(plane)] = -np.inf
+    for y0, y1, x0, x1 in suppressed:
+        plane[y0:y1, x0:x1] = -np.inf
+    index = int(np.argmax(plane))
+    y, x = divmod(index, plane.shape[1])
+    return float(plane[y, x]), (y, x)
+
+
+def find_peaks(volume, count=HOTSPOT_PEAKS, radius=HOTSPOT_RADIUS, box=None, frame=0, stats=None, workers=None):
+    """Hottest voxels of a ZYX box ((z0, z1), (y0, y1), (x0, x1)), as [(value, (x, y, z))]
+
+    Peaks come in decreasing order. With a radius, only local maxima are
+    peaks: voxels no lower than any other of the box within radius voxels
+    (in every axis), so a lesion wider than the radius still yields a single
+    peak rather than its shoulders. radius 0 returns the hottest voxels.
+
+    Candidates are taken hottest first. Once a candidate is accepted or
+    rejected, its neighbourhood is excluded: no voxel there can be a local
+    maximum (up to ties), as the candidate is higher than all that remain.
+    The maximum of every slice of the box is reduced in parallel threads,
+    then kept up to date: an exclusion only rescans the slices it touches,
+    once the search reaches them. With stats.VolumeStats of the frame, a
+    box spanning whole slices starts from their stored maxima and scans
+    only the slices the search actually visits.
+    """
+    volume = frame_volume(volume, frame)
+    (z0, z1), (y0, y1), (x0, x1) = _clip_box(
+        box or ((0, volume.shape[0]), (0, volume.shape[1]), (0, volume.shape[2])), volume.shape
+    )
+    if z1 <= z0 or y1 <= y0 or x1 <= x0:
+        return []
+    suppressed = []  # ZYX boxes excluded from the search, relative to the box
+    maxima = np.full(z1 - z0, -np.inf)
+    exact = np.zeros(z1 - z0, dtype=bool)  # Maxima computed with the exclusions
+    positions = {}
+
+    def scan(z):
+        boxes = [(a, b, c, d) for (za, zb), (a, b), (c, d) in suppressed if za <= z < zb]
+        return _slice_max(volume[z0 + z, y0:y1, x0:x1], boxes)
+
+    def neighbourhood(z, y, x):
+        return (
+            (max(0, z - radius), min(z1 - z0, z + radius + 1)),
+            (max(0, y - radius), min(y1 - y0, y + radius + 1)),
+            (max(0, x - radius), min(x1 - x0, x + radius + 1)),
+        )
+
+    whole_slices = (y0, y1, x0, x1) == (0, volume.shape[1], 0, volume.shape[2])
+    with ThreadPoolExecutor(max_workers=workers or os.cpu_count()) as pool:
+
+        def rescan(indices):
+            for z, (value, position) in zip(indices, pool.map(scan, indices)):
+                maxima[z], positions[z], exact[z] = value, position, True
+
+        if stats is not None and whole_slices and stats.shape == volume.shape:
+            # Upper bounds, made exact as the search reaches them
+            maxima[:] = np.nan_to_num(stats.slices[0]["max"][z0:z1], nan=-np.inf)
+        else:
+            rescan(list(range(z1 - z0)))
+
+        peaks = []
+        while len(peaks) < count:
+            z = int(np.argmax(maxima))
+            value = maxima[z]
+            if value == -np.inf:
+                break
+            if not exact[z]:
+                rescan([z])
+                continue
+            y, x = positions[z]
+            around = neighbourhood(z, y, x)
+            if radius > 0:
+                (a, b), (c, d), (e, f) = around
+                region = np.asarray(volume[z0 + a : z0 + b, y0 + c : y0 + d, x0 + e : x0 + f], dtype=np.float32)
+                is_peak = not np.fmax.reduce(region, axis=None) > value
+            else:
+                is_peak = True
+            if is_peak:
+                peaks.append((float(value), (x0 + x, y0 + y, z0 + z)))
+            suppressed.append(around)
+            # Bounds of the touched slices only decrease, they are rescanned once reached
+            exact[around[0][0] : around[0][1]] = False
+    return peaks
@@ -1,18 +1,194 @@
 #!/usr/bin/env python
+import glob
+import os
+from concurrent.futures import ThreadPoolExecutor
 import numpy as np
+from geometry import ImageGeometry
+
+# TODO: remove dependency from python_tools (still used for rawd and DICOM)
+
+BIN_CHUNK_VOXELS = 1 << 24  # Input voxels binned at once per task
+
+
+def map_raw_volume(filename, shape, dtype=np.float32):
+    """Memory-map a headerless raw file of this (ZYX or TZYX) shape, read only where viewed"""
+    expected = int(np.prod(shape)) * np.dtype(dtype).itemsize
+    size = os.path.getsize(filename)
+    if size != expected:
+        raise ValueError(
+            f"File size mismatch: {filename} holds {size} bytes, "
+            f"{'x'.join(str(n) for n in shape)} {np.dtype(dtype).name} voxels need {expected}"
+        )
+    return np.memmap(filename, dtype=dtype, mode="r", shape=tuple(shape))
 
 
 def load_raw_volume(filename, nx, ny, nz):
     """Load volume from raw binary file"""
+    return map_raw_volume(filename, (nz, ny, nx))  # Note ZYX ordering for numpy
+
+
+def parse_raw_shape(text):
+    """ZYX (or TZYX) shape of a raw format suffix such as "300x512x512" """
     try:
-        data = np.fromfile(filename, dtype=np.float32)
-        expected_size = nx * ny * nz
-        if len(data) != expected_size:
+        shape = tuple(int(n) for n in text.lower().split("x"))
+    except ValueError:
+        shape = ()
+    if len(shape) not in (3, 4) or min(shape) <= 0:
+        raise ValueError(f"Raw shape {text!r} is not NZxNYxNX or NTxNZxNYxNX")
+    return shape
+
+
+def load_numpy_volume(filename, mmap=True):
+    """Load a .npy volume, memory-mapped so that only the parts viewed are read"""
+    return np.load(filename, mmap_mode="r" if mmap else None)
+
+
+def parse_crop(text):
+    """ZYX slices of a "z0:z1,y0:y1,x0:x1" crop, empty bounds meaning the whole axis"""
+    parts = text.split(",")
+    if len(parts) != 3 or any(p.count(":") != 1 for p in parts):
+        raise ValueError(f"Crop {text!r} is not z0:z1,y0:y1,x0:x1")
+    return tuple(slice(*[int(v) if v.strip() else None for v in p.split(":")]) for p in parts)
+
+
+def crop_start(crop, shape):
+    """XYZ index of the first voxel kept by a crop of a volume of this (ZYX) shape"""
+    if crop is None:
+        return (0, 0, 0)
+    return tuple(c.indices(n)[0] for c, n in zip(crop, shape[-3:]))[::-1]
+
+
+def reduce_volume(volume, crop=None, bin=1, workers=None):
+    """Crop the last three axes of a volume, then average bin^3 blocks
+
+    Only the cropped voxels are read: a memory-mapped volume stays mapped
+    when not binned, and is otherwise read and binned slab by slab in
+    parallel threads, so only the binned result becomes resident. Voxels
+    left over when an axis is not a multiple of bin are dropped.
+    """
+    view = volume[(Ellipsis,) + tuple(crop)] if crop is not None else volume
+    if any(n == 0 for n in view.shape[-3:]):
+        raise ValueError(f"Crop leaves an empty volume of shape {view.shape}")
+    if bin == 1:
+        return view if isinstance(view, np.memmap) or view is volume else np.ascontiguousarray(view)
+
+    nz, ny, nx = (n // bin for n in view.shape[-3:])
+    if nz == 0 or ny == 0 or nx == 0:
+        raise ValueError(f"Cannot bin a volume of shape {view.shape} by {bin}")
+    dtype = np.float64 if view.dtype == np.float64 else np.float32
+    leading = view.shape[:-3]
+    binned = np.empty(leading + (nz, ny, nx), dtype=dtype)
+    step = max(1, BIN_CHUNK_VOXELS // (int(np.prod(leading)) * ny * nx * bin**3))
+
+    def bin_slab(z0):
+        z1 = min(z0 + step, nz)
+        slab = np.asarray(view[..., z0 * bin : z1 * bin, : ny * bin, : nx * bin])
+        blocks = slab.reshape(leading + (z1 - z0, bin, ny, bin, nx, bin))
+        binned[..., z0:z1, :, :] = blocks.sum(axis=(-5, -3, -1), dtype=dtype) / bin**3
+
+    with ThreadPoolExecutor(max_workers=workers or os.cpu_count()) as pool:
+        list(pool.map(bin_slab, range(0, nz, step)))
+    return binned
+
+
+class _ImageBuffer:
+    """Exposes the pixel buffer of a SimpleITK image, keeping the image alive"""
+
+    def __init__(self, image, view):
+        self.image = image
+        self.__array_interface__ = view.__array_interface__
+
+
+def load_sitk_volume(filename, crop=None):
+    """Load any SimpleITK-readable volume along with its geometry
+
+    The array views the image's own buffer instead of a copy of it, which
+    would briefly double the memory of every volume loaded. A crop (ZYX
+    slices) is read as an extract region, which readers supporting
+    streaming (e.g. uncompressed NIfTI, MHA) read without the rest of the
+    file; the geometry is then that of the region.
+    """
+    import SimpleITK as sitk
+
+    reader = sitk.ImageFileReader()
+    reader.SetFileName(filename)
+    if crop is not None:
+        reader.ReadImageInformation()
+        size = list(reader.GetSize())
+        ranges = [c.indices(n)[:2] for c, n in zip(crop[::-1], size[:3])]  # XYZ
+        reader.SetExtractIndex([a for a, _ in ranges] + [0] * (len(size) - 3))
+        reader.SetExtractSize([max(0, b - a) for a, b in ranges] + size[3:])
+    image = reader.Execute()
+    view = sitk.GetArrayViewFromImage(image)
+    return np.asarray(_ImageBuffer(image, view)), ImageGeometry.from_sitk(image)
+
+
+def load_image(filename, format="sitk", spacing=None, crop=None, bin=1):
+    """Load a volume in one of the command line formats, with its geometry
+
+    Raw f32/f64 files given with their shape ("f32:NZxNYxNX") are
+    memory-mapped. spacing ("sx,sy,sz" or a sequence) overrides the spacing
+    of the file, or provides one for formats without geometry metadata. crop (ZYX slices,
+    see parse_crop) and bin reduce the volume while it is read, see
+    reduce_volume. Returns (volume, geometry), geometry being None when
+    nothing is known.
+    """
+    geometry = None
+    offset = np.zeros(3)  # XYZ index of the first voxel read, when cropped while reading
+    format, _, layout = format.partition(":")
+    if format == "f32" or format == "f64":
+        dtype = np.float32 if format == "f32" else np.float64
+        if layout:
+            # Mapped, crop and bin below read only the voxels they keep
+            img = map_raw_volume(filename, parse_raw_shape(layout), dtype)
+        elif crop is not None or bin > 1:
             raise ValueError(
-                f"File size mismatch. Expected {expected_size} elements "
-                f"({nx}x{ny}x{nz}), got {len(data)}"
+                f"Cropping or binning a raw file needs its shape, e.g. -f {format}:NZxNYxNX"
             )
-        return data.reshape((nz, ny, nx))  # Note ZYX ordering for numpy
-    except Exception as e:
-        raise RuntimeError(f"Error loading volume: {str(e)}")
+        else:
+            import python_tools.iotools as ptio
+
+            img = ptio.DataFileRawd().load(filename, dtype=dtype)
+    elif format == "dicom" or format == "dcm":
+        import python_tools.iotools as ptio
+
+        sorted_glob = [f for f in sorted(glob.glob(filename)) if os.path.isfile(f)]
+        if crop is not None:  # Files outside of the z range are not read
+            offset[2] = crop[0].indices(len(sorted_glob))[0]
+            sorted_glob = sorted_glob[crop[0]]
+            crop = (slice(None),) + tuple(crop[1:])
+        img = None
+        for z, file_path in enumerate(sorted_glob):
+            data = ptio.DataFileDicom().load(file_path)
+            if img is None:
+                # Filled in place, stacking a list of slices needs twice the memory
+                img = np.empty((len(sorted_glob),) + data.shape, dtype=data.dtype)
+            img[z] = data
+        if img is None:
+            raise ValueError(f"No DICOM file matches {filename!r}")
+    elif format == "sitk" or format == "nii":
+        img, geometry = load_sitk_volume(filename, crop)
+        crop = None  # Already read as a region, with its own origin
+        if(len(img.shape) > 3):
+            img = np.squeeze(img)
+    elif format == "npy" or format == "np":
+        img = load_numpy_volume(filename)
+        if(len(img.shape) > 3):
+            img = np.squeeze(img)
+    else:
+        raise ValueError(f"Unknown format {format!r}")
+
+    if spacing is not None:
+        if isinstance(spacing, str):
+            spacing = [float(v) for v in spacing.split(',')]
+        origin = geometry.origin if geometry is not None else None
+        direction = geometry.direction if geometry is not None else None
+        geometry = ImageGeometry(spacing, origin, direction)
+
+    if crop is not None or bin > 1:
+        start = offset + crop_start(crop, img.shape)
+        img = reduce_volume(img, crop, bin)
+        # Unit voxels at the origin otherwise, so the region keeps its place in the file
+        geometry = (geometry or ImageGeometry()).cropped(start, bin)
 
+    return img, geometry
@@ -0,0 +1,186 @@
+#!/usr/bin/env python
+import atexit
+import multiprocessing
+from concurrent.futures import ProcessPoolExecutor, ThreadPoolExecutor
+from functools import partial
+from multiprocessing import resource_tracker
+from multiprocessing.shared_memory import SharedMemory
+import numpy as np
+from image_loader import load_image
+from storage import QuantizedArray
+
+# Decoders spending their time in C code that releases the GIL (SimpleITK,
+# numpy file reads and memory maps), so threads load them in parallel. The
+# same holds for numpy reductions and conversions and zlib on large buffers,
+# which is why the per-slab passes elsewhere (stats, storage, roi, watch) use
+# thread pools too. The others, e.g. DICOM parsed in Python, are loaded in
+# worker processes.
+GIL_FREE_FORMATS = {"sitk", "nii", "npy", "np", "f32", "f64"}
+
+
+class SharedBuffer:
+    """Exposes an array in shared memory, keeping the mapping alive
+
+    An owner removes the block's name once the array is released. Until
+    then other processes can attach to the block by name, see volume_spec.
+    """
+
+    def __init__(self, shm, shape, dtype, offset=0, strides=None, owner=False):
+        self.shm = shm
+        if owner:
+            _OWNED[shm.name] = shm
+        array = np.ndarray(shape, dtype, buffer=shm.buf, offset=offset, strides=strides)
+        self.__array_interface__ = array.__array_interface__
+
+    def __del__(self):
+        if _OWNED.pop(self.shm.name, None) is not None:
+            self.shm.unlink()
+
+
+# Blocks this process owns, unlinked at exit at the latest
+_OWNED = {}
+
+
+@atexit.register
+def _unlink_owned():
+    while _OWNED:
+        _OWNED.popitem()[1].unlink()
+
+
+def hand_over(shm):
+    """Leave a block created here to the process that will own it
+
+    The creator stops tracking it, otherwise the resource tracker reports
+    it as leaked (and unlinks it) although its owner unlinks it in time.
+    """
+    resource_tracker.unregister(shm._name, "shared_memory")
+
+
+def to_shared(array):
+    """Copy an array to a new shared memory block, return (name, shape, dtype)
+
+    The block outlives this process, until an owner from_shared releases it.
+    """
+    shm = SharedMemory(create=True, size=max(array.nbytes, 1))
+    np.ndarray(array.shape, dtype=array.dtype, buffer=shm.buf)[...] = array
+    hand_over(shm)
+    shm.close()
+    return shm.name, array.shape, array.dtype.str
+
+
+def empty_shared(shape, dtype):
+    """Zero-filled array in a new shared memory block this process owns"""
+    dtype = np.dtype(dtype)
+    shm = SharedMemory(create=True, size=max(int(np.prod(shape)) * dtype.itemsize, 1))
+    return np.asarray(SharedBuffer(shm, shape, dtype, owner=True))
+
+
+def from_shared(name, shape, dtype, offset=0, strides=None, owner=False):
+    """Array over an existing shared memory block, without copying it
+
+    An owner unlinks the block once the returned array is released.
+    """
+    shm = SharedMemory(name=name)
+    return np.asarray(SharedBuffer(shm, shape, np.dtype(dtype), offset, strides, owner))
+
+
+def _root(array):
+    """The array owning the memory an ndarray views"""
+    while isinstance(array.base, np.ndarray):
+        array = array.base
+    return array
+
+
+def _address(array):
+    return array.__array_interface__["data"][0]
+
+
+def volume_spec(volume):
+    """Picklable description another process can map a volume from, or None
+
+    Volumes in shared memory are attached by name and memory-mapped files
+    are mapped again, without copying. Lazy volumes cannot be shared.
+    """
+    if isinstance(volume, QuantizedArray):
+        codes = volume_spec(volume.codes)
+        return codes and ("quantized", codes, volume.slope, volume.intercept)
+    if not isinstance(volume, np.ndarray):
+        return None
+    root = _root(volume)
+    view = (_address(volume) - _address(root), volume.shape, volume.strides, volume.dtype.str)
+    if isinstance(root.base, SharedBuffer):
+        return ("shm", root.base.shm.name) + view
+    if isinstance(root, np.memmap) and root.filename is not None:
+        return ("file", root.filename, root.offset, root.nbytes) + view
+    return None
+
+
+def open_volume(spec):
+    """Map a volume described by volume_spec"""
+    if spec[0] == "quantized":
+        return QuantizedArray(open_volume(spec[1]), *spec[2:])
+    if spec[0] == "shm":
+        _, name, offset, shape, strides, dtype = spec
+        return from_shared(name, shape, dtype, offset, strides)
+    _, filename, start, nbytes, offset, shape, strides, dtype = spec
+    data = np.memmap(filename, dtype=np.uint8, mode="r", offset=start, shape=(nbytes,))
+    return np.ndarray(shape, dtype, buffer=data, offset=offset, strides=strides)
+
+
+def share_volume(volume):
+    """(volume, spec) with the volume moved to shared memory if it must be
+
+    In-memory arrays are copied to a shared memory block once, the returned
+    array replaces them. spec is None for volumes that cannot be shared.
+    """
+    if isinstance(volume, np.ndarray) and volume_spec(volume) is None:
+        volume = from_shared(*to_shared(np.ascontiguousarray(volume)), owner=True)
+    elif isinstance(volume, QuantizedArray) and volume_spec(volume) is None:
+        volume = QuantizedArray(share_volume(volume.codes)[0], volume.slope, volume.intercept)
+    return volume, volume_spec(volume)
+
+
+def _load_to_shared(filename, format, spacing, crop=None, bin=1):
+    img, geometry = load_image(filename, format, spacing, crop, bin)
+    return to_shared(np.asarray(img)), geometry
+
+
+def _from_process(future):
+    (name, shape, dtype), geometry = future.result()
+    return from_shared(name, shape, dtype, owner=True), geometry
+
+
+def _load(load, index, postprocess):
+    volume, geometry = load()
+    if postprocess is not None:
+        volume = postprocess(index, volume)
+    return volume, geometry
+
+
+def load_images(specs, postprocess=None, workers=None):
+    """Start loading (filename, format, spacing[, crop, bin]) specs concurrently
+
+    Returns one Future per spec, resolving to (volume, geometry) in whatever
+    order the files finish. postprocess(index, volume) -> volume runs in the
+    loading thread once a volume is in memory.
+    """
+    workers = workers or len(specs) or 1
+    threads = ThreadPoolExecutor(max_workers=workers)
+    processes = None
+    futures = []
+    for index, spec in enumerate(specs):
+        if spec[1].partition(":")[0] in GIL_FREE_FORMATS:
+            load = partial(load_image, *spec)
+        else:
+            # Spawned, forking the threaded Qt parent is not safe
+            if processes is None:
+                processes = ProcessPoolExecutor(
+                    max_workers=workers, mp_context=multiprocessing.get_context("spawn")
+                )
+            load = partial(_from_process, processes.submit(_load_to_shared, *spec))
+        futures.append(threads.submit(_load, load, index, postprocess))
+    # Submitted work still runs, the pools wind down once it is done
+    threads.shutdown(wait=False)
+    if processes is not None:
+        processes.shutdown(wait=False)
+    return futures
@@ -0,0 +1,111 @@
+#!/usr/bin/env python
+import os
+import re
+import numpy as np
+
+_UNITS = {"": 1, "k": 1 << 10, "m": 1 << 20, "g": 1 << 30, "t": 1 << 40}
+
+
+def parse_bytes(text):
+    """Byte count of a size such as "512M", "4G", "1.5GB" or "1000000" """
+    match = re.fullmatch(r"\s*([\d.]+)\s*([kmgt]?)i?b?\s*", str(text).lower())
+    if match is None:
+        raise ValueError(f"Invalid size {text!r}, expected e.g. 512M or 4G")
+    return int(float(match.group(1)) * _UNITS[match.group(2)])
+
+
+def format_bytes(n):
+    for unit in ("B", "KB", "MB", "GB"):
+        if abs(n) < 1024 or unit == "GB":
+            return f"{n:.0f} {unit}" if unit == "B" else f"{n:.1f} {unit}"
+        n /= 1024
+
+
+def default_budget():
+    """Half of the physical memory, 4 GB when it cannot be queried"""
+    try:
+        return os.sysconf("SC_PAGE_SIZE") * os.sysconf("SC_PHYS_PAGES") // 2
+    except (ValueError, OSError, AttributeError):
+        return 4 << 30
+
+
+def resident_bytes(volume):
+    """Bytes a volume holds in memory, 0 if it is lazy or memory-mapped
+
+    Mapped pages are backed by the file and reclaimed by the OS on its own.
+    """
+    if getattr(volume, "lazy", False):
+        return 0
+    array = volume
+    while isinstance(array, np.ndarray):
+        if isinstance(array, np.memmap):
+            return 0
+        array = array.base
+    return int(getattr(volume, "nbytes", 0))
+
+
+class MemoryGovernor:
+    """Process-wide memory budget over the loaded volumes and every cache
+
+    Volumes are counted but never evicted. Caches are registered with a
+    visible() callable telling whether the viewer owning them is on screen,
+    and follow a small protocol: an nbytes and a last_used attribute, and
+    evict(nbytes) dropping their least recently used entries. trim() runs
+    on the GUI thread only: from the manager's timer, and from caches that
+    only grow on the GUI thread (tiles, ROI tables). Caches also filled by
+    worker threads lock themselves against the evictions. Over budget, the
+    caches of offscreen viewers are evicted first, then the least recently
+    used ones.
+    """
+
+    def __init__(self, budget=None):
+        self.budget = budget or default_budget()
+        self.volumes = {}  # id(volume) -> volume
+        self.caches = []  # (cache, visible)
+
+    def add_volume(self, volume):
+        self.volumes[id(volume)] = volume
+
+    def remove_volume(self, volume):
+        self.volumes.pop(id(volume), None)
+
+    def register(self, cache, visible=None):
+        cache.governor = self
+        self.caches.append((cache, visible or (lambda: True)))
+        self.trim()
+
+    def unregister(self, cache):
+        self.caches = [entry for entry in self.caches if entry[0] is not cache]
+        cache.governor = None
+
+    @property
+    def volume_bytes(self):
+        return sum(resident_bytes(v) for v in self.volumes.values())
+
+    @property
+    def cache_bytes(self):
+        return sum(cache.nbytes for cache, _ in self.caches)
+
+    @property
+    def usage(self):
+        return self.volume_bytes + self.cache_bytes
+
+    def trim(self):
+        """Evict cache entries until the usage fits the budget, return bytes freed"""
+        excess = self.usage - self.budget
+        if excess <= 0:
+            return 0
+        freed = 0
+        # Offscreen (visible() False) first, least recently used first
+        for cache, _ in sorted(self.caches, key=lambda e: (e[1](), e[0].last_used)):
+            if freed >= excess:
+                break
+            freed += cache.evict(excess - freed)
+        return freed
+
+    def summary(self):
+        volumes, caches = self.volume_bytes, self.cache_bytes
+        return (
+            f"Memory: {format_bytes(volumes + caches)} / {format_bytes(self.budget)} "
+            f"(volumes {format_bytes(volumes)}, caches {format_bytes(caches)})"
+        )
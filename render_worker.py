@@ -0,0 +1,150 @@
+#!/usr/bin/env python
+import multiprocessing
+import time
+from multiprocessing.shared_memory import SharedMemory
+import numpy as np
+from PyQt5.QtCore import QObject, QSocketNotifier, pyqtSignal
+from loading import from_shared, hand_over, open_volume
+from rendering import SliceCache, TileCache
+
+
+def _serve(conn, spec):
+    """Render loop of a worker process, over a volume mapped from spec
+
+    Frames are written to a shared block of two slots, alternately, and
+    only their slot is sent back. The client has at most one request in
+    flight and handles every frame (adopting it, or copying out the frame
+    it keeps showing) before sending the next request, so the slot it
+    shows is never the one being written.
+    """
+    volume = open_volume(spec)
+    slice_cache = SliceCache(volume)
+    tile_cache = TileCache()
+    frames = None
+    slot = 0
+    while True:
+        message = conn.recv()
+        if message[0] == "close":
+            break
+        if message[0] == "invalidate":
+            _, orientation, index = message
+            slice_cache.invalidate(orientation, index)
+            if orientation is None:
+                tile_cache.clear()
+            else:
+                tile_cache.invalidate(orientation, index)
+            continue
+        if message[0] == "evict":
+            # Asked by the client's MemoryGovernor, tiles first as they are cheaper to redo
+            nbytes = message[1]
+            nbytes -= tile_cache.evict(nbytes)
+            if nbytes > 0:
+                slice_cache.evict(nbytes)
+            continue
+
+        _, key, slice_key, view_rect, out_w, out_h, window_level, method = message
+        slice_data = slice_cache.get(*slice_key[1:], slice_key[0])
+        indices, rect = tile_cache.render(
+            slice_data, slice_key, view_rect, out_w, out_h, window_level, method
+        )
+        name = None
+        if frames is None or frames.size < 2 * indices.size:
+            if frames is not None:
+                frames.close()
+            # The client owns (and unlinks) every block it is sent
+            frames = SharedMemory(create=True, size=2 * indices.size)
+            hand_over(frames)
+            name = frames.name
+        slot = 1 - slot
+        view = np.ndarray(indices.shape, np.uint8, frames.buf, slot * (frames.size // 2))
+        view[...] = indices
+        del view
+        cache_bytes = slice_cache.nbytes + tile_cache.nbytes
+        conn.send(("frame", key, name, frames.size, slot, indices.shape, rect, cache_bytes))
+    if frames is not None:
+        frames.close()
+
+
+class RenderWorker(QObject):
+    """Renders the windowed frames of one viewer in its own process
+
+    The volume is mapped in the worker, not copied: spec comes from
+    loading.volume_spec. Requests and replies travel over a pipe, watched by
+    the event loop, and frames come back through shared memory. While a
+    request is in flight only the latest new one is kept, so a burst of
+    interaction never queues up stale work.
+
+    The worker's slice and tile caches count against the client's memory
+    budget: a RenderWorker follows the MemoryGovernor cache protocol, its
+    nbytes reported back with every frame and evict() forwarded to the worker.
+    """
+
+    frame_ready = pyqtSignal(object, object, object)  # (key, indices, rendered rect)
+
+    def __init__(self, spec, parent=None):
+        super().__init__(parent)
+        context = multiprocessing.get_context("spawn")
+        self.conn, child_conn = context.Pipe()
+        self.process = context.Process(target=_serve, args=(child_conn, spec), daemon=True)
+        self.process.start()
+        child_conn.close()
+        self.frames = None  # (2, slot bytes) view of the shared frame block
+        self.busy = False
+        self.queued = None
+        self.nbytes = 0  # Worker cache bytes, as of its last frame
+        self.last_used = time.monotonic()
+        self.governor = None  # MemoryGovernor, see memory.py
+        self.notifier = QSocketNotifier(self.conn.fileno(), QSocketNotifier.Read, self)
+        self.notifier.activated.connect(self._receive)
+
+    def request(self, key, slice_key, view_rect, out_w, out_h, window_level, method="nearest"):
+        """Render a frame, key is handed back with it through frame_ready"""
+        self.last_used = time.monotonic()
+        message = ("render", key, slice_key, tuple(view_rect), out_w, out_h, tuple(window_level), method)
+        if self.busy:
+            self.queued = message
+            return
+        self.conn.send(message)
+        self.busy = True
+
+    def invalidate(self, orientation=None, index=None):
+        """Drop the worker's cached slices and tiles, e.g. after the data changed"""
+        self.conn.send(("invalidate", orientation, index))
+
+    def evict(self, nbytes):
+        """Have the worker drop least recently used slices and tiles, return bytes freed"""
+        freed = min(nbytes, self.nbytes)
+        if freed > 0 and self.process.is_alive():
+            self.conn.send(("evict", freed))
+            self.nbytes -= freed
+        return freed
+
+    def _receive(self):
+        while self.conn.poll():
+            _, key, name, size, slot, shape, rect, self.nbytes = self.conn.recv()
+            if name is not None:
+                self.frames = from_shared(name, (2, size // 2), np.uint8, owner=True)
+            count = shape[0] * shape[1]
+            indices = self.frames[slot, :count].reshape(shape)
+            self.busy = False
+            # Handled first: the next frame goes to the slot shown until now
+            self.frame_ready.emit(key, indices, rect)
+            if self.queued is not None and not self.busy:
+                self.conn.send(self.queued)
+                self.queued, self.busy = None, True
+
+    def close(self):
+        if self.governor is not None:
+            self.governor.unregister(self)
+        if self.process.is_alive():
+            self.notifier.setEnabled(False)
+            self.conn.send(("close",))
+            self.process.join(1)
+            # A frame in flight may come in a new block, which is ours to unlink
+            try:
+                while self.conn.poll():
+                    message = self.conn.recv()
+                    if message[2] is not None:
+                        from_shared(message[2], (message[3],), np.uint8, owner=True)
+            except EOFError:
+                pass
@@ -0,0 +1,564 @@
+#!/usr/bin/env python
+import threading
+import time
+from collections import OrderedDict
+from functools import lru_cache
+import numpy as np
+from geometry import PLANE_AXES
+
+INTERPOLATIONS = ("nearest", "bilinear", "bicubic", "lanczos")
+
+# Colormap name -> per-channel (position, value) control points
+COLORMAPS = {
+    "gray": (
+        ((0, 0), (1, 1)),
+        ((0, 0), (1, 1)),
+        ((0, 0), (1, 1)),
+    ),
+    "hot": (
+        ((0, 0.0416), (0.365, 1), (1, 1)),
+        ((0, 0), (0.365, 0), (0.746, 1), (1, 1)),
+        ((0, 0), (0.746, 0), (1, 1)),
+    ),
+    "jet": (
+        ((0, 0), (0.35, 0), (0.66, 1), (0.89, 1), (1, 0.5)),
+        ((0, 0), (0.125, 0), (0.375, 1), (0.64, 1), (0.91, 0), (1, 0)),
+        ((0, 0.5), (0.11, 1), (0.34, 1), (0.65, 0), (1, 0)),
+    ),
+    "rainbow": (
+        ((0, 0), (0.5, 0), (0.75, 1), (1, 1)),
+        ((0, 0), (0.25, 1), (0.75, 1), (1, 0)),
+        ((0, 1), (0.25, 1), (0.5, 0), (1, 0)),
+    ),
+}
+
+
+class LazyFrame:
+    """One time frame of a lazy TZYX volume, only computed for the regions indexed
+
+    Indexing the frame alone would compute it whole; the frame is kept in
+    the key instead, so a slice or a region reads only its own voxels.
+    """
+
+    lazy = True
+
+    def __init__(self, volume, frame):
+        self.volume = volume
+        self.frame = frame
+        self.shape = tuple(volume.shape[1:])
+        self.ndim = len(self.shape)
+        self.dtype = volume.dtype
+
+    def __len__(self):
+        return self.shape[0]
+
+    def __getitem__(self, key):
+        return self.volume[(self.frame,) + (key if isinstance(key, tuple) else (key,))]
+
+
+def frame_volume(volume, frame=0):
+    """3D volume of one time frame of a TZYX series (3D volumes are returned as is)"""
+    if volume.ndim == 4:
+        frame = min(frame, volume.shape[0] - 1)
+        if getattr(volume, "lazy", False):
+            return LazyFrame(volume, frame)
+        return volume[frame]
+    return volume
+
+
+def num_frames(volume):
+    return volume.shape[0] if volume.ndim == 4 else 1
+
+
+def extract_slice(volume, orientation, index, frame=0):
+    """Return the 2D slice of a ZYX volume for an orientation (0=XY, 1=XZ, 2=YZ)"""
+    volume = frame_volume(volume, frame)
+    if orientation == 0:  # XY
+        return volume[index]
+    elif orientation == 1:  # XZ
+        return volume[:, index]
+    return volume[:, :, index]  # YZ
+
+
+def voxel_value(volume, index_xyz, frame=0):
+    """Value of one voxel, read directly without extracting its slice"""
+    x, y, z = (int(i) for i in index_xyz)
+    key = (min(frame, volume.shape[0] - 1), z, y, x) if volume.ndim == 4 else (z, y, x)
+    return float(volume[key])
+
+
+def slice_shape(volume, orientation):
+    """(rows, columns) of the slices of an orientation"""
+    nz, ny, nx = volume.shape[-3], volume.shape[-2], volume.shape[-1]
+    return {0: (ny, nx), 1: (nz, nx), 2: (nz, ny)}[orientation]
+
+
+def num_slices(volume, orientation):
+    """Number of slices along the axis normal to the given orientation"""
+    nz, ny, nx = volume.shape[-3], volume.shape[-2], volume.shape[-1]
+    return {0: nz, 1: ny, 2: nx}[orientation]
+
+
+def volume_range(volume):
+    """(min, max) of a volume, estimated for lazily computed volumes
+
+    For time series only a few evenly spaced frames are read, so a
+    memory-mapped series is not paged in entirely.
+    """
+    if hasattr(volume, "estimate_range"):
+        return volume.estimate_range()
+    if volume.ndim == 4:
+        frames = [volume[t] for t in range(0, volume.shape[0], max(1, volume.shape[0] // 4))]
+        return [min(np.min(f) for f in frames), max(np.max(f) for f in frames)]
+    return [np.min(volume), np.max(volume)]
+
+
+class LazySlice:
+    """2D slice of a lazy volume, only computed for the regions indexed"""
+
+    def __init__(self, volume, orientation, index, frame=0):
+        self.volume = frame_volume(volume, frame)
+        self.orientation = orientation
+        self.index = index
+        self.shape = slice_shape(volume, orientation)
+
+    def __getitem__(self, key):
+        rows, cols = key
+        if self.orientation == 0:
+            return self.volume[self.index, rows, cols]
+        elif self.orientation == 1:
+            return self.volume[rows, self.index, cols]
+        return self.volume[rows, cols, self.index]
+
+
+class SliceCache:
+    """LRU cache of contiguous slices extracted from one volume
+
+    Several views of the same volume (e.g. the three panes of a tri-planar
+    layout, or two viewers opened on the same array) share one instance so
+    that a strided XZ/YZ extraction is only paid once.
+    """
+
+    def __init__(self, volume, max_slices=64):
+        self.volume = volume
+        self.max_slices = max_slices
+        self._slices = OrderedDict()
+        self._lock = threading.Lock()  # Filled from worker threads, evicted from the GUI
+        self.nbytes = 0
+        self.last_used = time.monotonic()
+        self.governor = None  # MemoryGovernor, see memory.py
+
+    def get(self, orientation, index, frame=0):
+        self.last_used = time.monotonic()
+        if getattr(self.volume, "lazy", False):
+            # Computed on demand, caching whole slices would defeat that
+            return LazySlice(self.volume, orientation, index, frame)
+
+        key = (orientation, index, frame)
+        with self._lock:
+            slice_data = self._slices.get(key)
+            if slice_data is not None:
+                self._slices.move_to_end(key)
+                return slice_data
+
+        slice_data = extract_slice(self.volume, orientation, index, frame)
+        if hasattr(slice_data, "contiguous"):  # Compact storage, see storage.py
+            slice_data = slice_data.contiguous()
+        else:
+            slice_data = np.ascontiguousarray(slice_data)
+        with self._lock:
+            if key not in self._slices:
+                self._slices[key] = slice_data
+                self.nbytes += slice_data.nbytes
+            while len(self._slices) > self.max_slices:
+                self.nbytes -= self._slices.popitem(last=False)[1].nbytes
+        return slice_data
+
+    def invalidate(self, orientation=None, index=None):
+        """Drop cached slices, optionally only those of one orientation/index"""
+        with self._lock:
+            for key in list(self._slices):
+                if orientation is None or (
+                    key[0] == orientation and (index is None or key[1] == index)
+                ):
+                    self.nbytes -= self._slices.pop(key).nbytes
+
+    def evict(self, nbytes):
+        """Drop least recently used slices until nbytes are freed, return bytes freed"""
+        freed = 0
+        with self._lock:
+            while self._slices and freed < nbytes:
+                freed += self._slices.popitem(last=False)[1].nbytes
+            self.nbytes -= freed
+        return freed
+
+
+def window_to_uint8(data, min_val, max_val):
+    """Apply a window level and quantize to 8 bits"""
+    span = max_val - min_val
+    if span == 0:
+        span = 1
+    data = np.clip((data - min_val) / span, 0, 1)
+    return (data * 255).astype(np.uint8)
+
+
+@lru_cache(maxsize=None)
+def colormap_lut(name):
+    """256-entry ARGB32 lookup table (uint32, 0xAARRGGBB) for a colormap"""
+    positions = np.linspace(0, 1, 256)
+    channels = []
+    for points in COLORMAPS[name]:
+        xp, fp = zip(*points)
+        channels.append(np.round(np.interp(positions, xp, fp) * 255).astype(np.uint32))
+    r, g, b = channels
+    lut = (np.uint32(0xFF) << 24) | (r << 16) | (g << 8) | b
+    lut.setflags(write=False)
+    return lut
+
+
+def _bilinear_kernel(x):
+    return np.maximum(1 - np.abs(x), 0)
+
+
+def _bicubic_kernel(x, a=-0.5):
+    # Keys cubic convolution
+    x = np.abs(x)
+    x2, x3 = x * x, x * x * x
+    return np.where(
+        x <= 1,
+        (a + 2) * x3 - (a + 3) * x2 + 1,
+        np.where(x < 2, a * x3 - 5 * a * x2 + 8 * a * x - 4 * a, 0),
+    )
+
+
+def _lanczos_kernel(x, a=3):
+    return np.where(np.abs(x) < a, np.sinc(x) * np.sinc(x / a), 0)
+
+
+# method -> (kernel, support radius in input samples)
+_KERNELS = {
+    "bilinear": (_bilinear_kernel, 1),
+    "bicubic": (_bicubic_kernel, 2),
+    "lanczos": (_lanczos_kernel, 3),
+}
+
+
+def nearest_indices(start, stop, in_size, out_size):
+    """Input sample hit by the center of each output pixel"""
+    centers = start + (np.arange(out_size) + 0.5) * (stop - start) / out_size
+    return np.clip(np.floor(centers).astype(np.int64), 0, in_size - 1)
+
+
+@lru_cache(maxsize=32)
+def resample_matrix(start, stop, in_size, out_size, method):
+    """Weights mapping input samples to output pixels along one axis
+
+    Output pixel i samples the input at the center of its footprint in
+    [start, stop). Returns (first, weights) where weights has shape
+    (n_inputs, out_size) and covers input samples first..first+n_inputs, so
+    only the samples actually reaching the output are read. When
+    minifying, the kernel is widened by the scale factor to avoid aliasing.
+    """
+    scale = (stop - start) / out_size
+    centers = start + (np.arange(out_size) + 0.5) * scale - 0.5
+    kernel, support = _KERNELS[method]
+    stretch = max(scale, 1.0)
+    support = support * stretch
+    taps = int(np.ceil(2 * support)) + 1
+    idx = np.floor(centers - support).astype(np.int64)[:, None] + np.arange(taps)
+    w = kernel((centers[:, None] - idx) / stretch)
+    idx = np.clip(idx, 0, in_size - 1)  # replicate edges
+
+    first = int(idx.min())
+    weights = np.zeros((int(idx.max()) - first + 1, out_size), dtype=np.float64)
+    outputs = np.broadcast_to(np.arange(out_size)[:, None], idx.shape)
+    np.add.at(weights, (idx - first, outputs), w)
+    weights /= weights.sum(axis=0, keepdims=True)
+    return first, weights.astype(np.float32)
+
+
+def resample_slice(slice_data, view_rect, out_w, out_h, method="nearest"):
+    """Resample the view_rect region of a 2D slice to an out_h x out_w frame
+
+    Each output pixel is evaluated from the raw (float) data, so windowing is
+    applied afterwards on the small frame only. The separable kernels reduce
+    to two matrix products over the visible input region.
+    """
+    x_min, x_max, y_min, y_max = (float(v) for v in view_rect)
+    h, w = slice_data.shape
+
+    if method == "nearest":
+        cols = nearest_indices(x_min, x_max, w, out_w)
+        rows = nearest_indices(y_min, y_max, h, out_h)
+        region = slice_data[rows[0] : rows[-1] + 1, cols[0] : cols[-1] + 1]
+        region = np.asarray(region, dtype=np.float32)
+        return region[(rows - rows[0])[:, None], (cols - cols[0])[None, :]]
+
+    col_first, col_weights = resample_matrix(x_min, x_max, w, out_w, method)
+    row_first, row_weights = resample_matrix(y_min, y_max, h, out_h, method)
+    region = slice_data[
+        row_first : row_first + row_weights.shape[0],
+        col_first : col_first + col_weights.shape[0],
+    ]
+    region = np.asarray(region, dtype=np.float32)
+    return row_weights.T @ (region @ col_weights)
+
+
+class TileCache:
+    """LRU cache of resampled, windowed screen tiles at fixed zoom levels
+
+    Output pixels lie on a grid anchored at the slice origin, so views at
+    the same zoom share tiles wherever they overlap. Panning only resamples
+    the tiles it newly exposes and copies the others, so its cost follows
+    how far the view moved rather than the size of the view. Tiles keep the
+    resampled data so a new window level only re-windows them.
+
+    At least views_kept views' worth of tiles are kept, whatever the canvas
+    size; beyond that the MemoryGovernor bounds the cache. Tile keys carry
+    the data version of their slice, so invalidating a slice is constant
+    time and its stale tiles just age out.
+    """
+
+    def __init__(self, tile_size=256, max_tiles=96, views_kept=2):
+        self.tile_size = tile_size
+        self.max_tiles = max_tiles
+        self.views_kept = views_kept
+        self._view_tiles = 0  # Tiles of the last rendered view
+        self._tiles = OrderedDict()  # key -> [data, window_level, indices]
+        self._versions = {}  # (orientation, index or None) -> data version
+        self.tile_bytes = tile_size * tile_size * 5  # float32 data + uint8 indices
+        self.last_used = time.monotonic()
+        self.governor = None  # MemoryGovernor, see memory.py
+
+    @property
+    def nbytes(self):
+        return len(self._tiles) * self.tile_bytes
+
+    def render(self, slice_data, slice_key, view_rect, out_w, out_h, window_level, method="nearest"):
+        """Return (indices, rendered_rect) for a view, out_h x out_w uint8
+
+        rendered_rect is view_rect snapped to the pixel grid of its zoom,
+        at most half an output pixel away from it.
+        """
+        x_min, x_max, y_min, y_max = (float(v) for v in view_rect)
+        scale_x = out_w / (x_max - x_min)
+        scale_y = out_h / (y_max - y_min)
+        u0 = int(round(x_min * scale_x))
+        v0 = int(round(y_min * scale_y))
+        size = self.tile_size
+        window_level = tuple(window_level)
+        self.last_used = time.monotonic()
+
+        columns = range(u0 // size, (u0 + out_w - 1) // size + 1)
+        rows = range(v0 // size, (v0 + out_h - 1) // size + 1)
+        self._view_tiles = len(columns) * len(rows)
+        _, orientation, index = slice_key
+        version = (self._versions.get((orientation, None), 0), self._versions.get((orientation, index), 0))
+        out = np.empty((out_h, out_w), dtype=np.uint8)
+        for j in rows:
+            for i in columns:
+                tile = self._tile(
+                    slice_data, (slice_key, version, scale_x, scale_y, method, i, j), window_level
+                )
+                # Overlap of the tile with the view, in grid pixels
+                a0, a1 = max(i * size, u0), min((i + 1) * size, u0 + out_w)
+                b0, b1 = max(j * size, v0), min((j + 1) * size, v0 + out_h)
+                out[b0 - v0 : b1 - v0, a0 - u0 : a1 - u0] = tile[
+                    b0 - j * size : b1 - j * size, a0 - i * size : a1 - i * size
+                ]
+        rendered_rect = (
+            u0 / scale_x,
+            (u0 + out_w) / scale_x,
+            v0 / scale_y,
+            (v0 + out_h) / scale_y,
+        )
+        return out, rendered_rect
+
+    def _tile(self, slice_data, key, window_level):
+        entry = self._tiles.get(key)
+        if entry is None:
+            _, _, scale_x, scale_y, method, i, j = key
+            size = self.tile_size
+            rect = (
+                i * size / scale_x,
+                (i + 1) * size / scale_x,
+                j * size / scale_y,
+                (j + 1) * size / scale_y,
+            )
+            entry = [resample_slice(slice_data, rect, size, size, method), None, None]
+            self._tiles[key] = entry
+            while len(self._tiles) > max(self.max_tiles, self.views_kept * self._view_tiles):
+                self._tiles.popitem(last=False)
+            if self.governor is not None:
+                self.governor.trim()
+        else:
+            self._tiles.move_to_end(key)
+        if entry[1] != window_level:
+            entry[1] = window_level
+            entry[2] = window_to_uint8(entry[0], *window_level)
+        return entry[2]
+
+    def clear(self):
+        self._tiles.clear()
+
+    def invalidate(self, orientation, index=None):
+        """Stop using the tiles of one orientation, optionally of one slice index only"""
+        key = (orientation, index)
+        self._versions[key] = self._versions.get(key, 0) + 1
+
+    def evict(self, nbytes):
+        """Drop least recently used tiles until nbytes are freed, return bytes freed"""
+        freed = 0
+        while self._tiles and freed < nbytes:
+            self._tiles.popitem(last=False)
+            freed += self.tile_bytes
+        return freed
+
+
+def plane_sample_points(transform, orientation, slice_index, view_rect, out_w, out_h):
+    """Continuous XYZ indices, shape (3, out_h, out_w), of the frame pixel centers
+
+    transform maps the displayed volume's indices to those of the sampled
+    volume, so the same frame can be sampled from a volume on another grid.
+    """
+    x_min, x_max, y_min, y_max = (float(v) for v in view_rect)
+    cols = x_min + (np.arange(out_w) + 0.5) * (x_max - x_min) / out_w - 0.5
+    rows = y_min + (np.arange(out_h) + 0.5) * (y_max - y_min) / out_h - 0.5
+    column_axis, row_axis, slice_axis = PLANE_AXES[orientation]
+    matrix, offset = transform[:3, :3], transform[:3, 3]
+    return (
+        matrix[:, column_axis, None, None] * cols[None, None, :]
+        + matrix[:, row_axis, None, None] * rows[None, :, None]
+        + (matrix[:, slice_axis] * slice_index + offset)[:, None, None]
+    )
+
+
+def sample_volume(volume, points, method="linear"):
+    """Sample a ZYX volume at continuous XYZ indices, NaN outside of it
+
+    Only the bounding box of the points is read from the volume, which keeps
+    this cheap on memory-mapped data. method is "nearest" or "linear".
+    """
+    shape = volume.shape[-1], volume.shape[-2], volume.shape[-3]  # nx, ny, nz
+    inside = np.ones(points.shape[1:], dtype=bool)
+    for coords, n in zip(points, shape):
+        inside &= (coords >= -0.5) & (coords <= n - 0.5)
+    out = np.full(points.shape[1:], np.nan, dtype=np.float32)
+    if not inside.any():
+        return out
+
+    # Bounding box of the samples, as (start, stop) per XYZ axis
+    box = []
+    for coords, n in zip(points, shape):
+        c = coords[inside]
+        box.append((max(int(np.floor(c.min())), 0), min(int(np.ceil(c.max())) + 1, n)))
+    (x0, x1), (y0, y1), (z0, z1) = box
+    region = np.asarray(volume[z0:z1, y0:y1, x0:x1], dtype=np.float32)
+
+    local = [
+        np.clip(coords[inside] - start, 0, stop - start - 1)
+        for coords, (start, stop) in zip(points, box)
+    ]
+    if method == "nearest":
+        x, y, z = (np.floor(c + 0.5).astype(np.int64) for c in local)
+        out[inside] = region[z, y, x]
+        return out
+
+    # Trilinear: 8 gathers weighted by the fractional offsets
+    lower = [np.floor(c).astype(np.int64) for c in local]
+    upper = [np.minimum(i + 1, n - 1) for i, n in zip(lower, region.shape[::-1])]
+    frac = [c - i for c, i in zip(local, lower)]
+    value = 0
+    for dz in (0, 1):
+        z, wz = (upper[2], frac[2]) if dz else (lower[2], 1 - frac[2])
+        for dy in (0, 1):
+            y, wy = (upper[1], frac[1]) if dy else (lower[1], 1 - frac[1])
+            for dx in (0, 1):
+                x, wx = (upper[0], frac[0]) if dx else (lower[0], 1 - frac[0])
+                value = value + region[z, y, x] * (wz * wy * wx)
+    out[inside] = value
+    return out
+
+
+def sample_line(volume, start, end, num, frame=0):
+    """Trilinear samples at num points evenly spaced from start to end (XYZ indices)
+
+    The 8 corner voxels of every sample are read with a single gather, so
+    the cost follows the number of samples, not the extent of the line.
+    NaN outside of the volume.
+    """
+    points = np.linspace(np.asarray(start, float), np.asarray(end, float), num, axis=1)
+    shape = volume.shape[-1], volume.shape[-2], volume.shape[-3]  # nx, ny, nz
+    inside = np.ones(num, dtype=bool)
+    for coords, n in zip(points, shape):
+        inside &= (coords >= -0.5) & (coords <= n - 0.5)
+    out = np.full(num, np.nan, dtype=np.float32)
+    if not inside.any():
+        return out
+
+    local = [np.clip(coords[inside], 0, n - 1) for coords, n in zip(points, shape)]
+    lower = [np.floor(c).astype(np.int64) for c in local]
+    upper = [np.minimum(i + 1, n - 1) for i, n in zip(lower, shape)]
+    frac = [c - i for c, i in zip(local, lower)]
+
+    # Corners in (dz, dy, dx) order, gathered at once then weighted
+    corners = [(dz, dy, dx) for dz in (0, 1) for dy in (0, 1) for dx in (0, 1)]
+    z, y, x = (
+        np.concatenate([(upper if d[axis] else lower)[2 - axis] for d in corners])
+        for axis in range(3)
+    )
+    key = (min(frame, volume.shape[0] - 1), z, y, x) if volume.ndim == 4 else (z, y, x)
+    values = np.asarray(volume[key], dtype=np.float32).reshape(len(corners), -1)
+    value = 0
+    for (dz, dy, dx), corner in zip(corners, values):
+        weight = (
+            (frac[2] if dz else 1 - frac[2])
+            * (frac[1] if dy else 1 - frac[1])
+            * (frac[0] if dx else 1 - frac[0])
+        )
+        value = value + corner * weight
+    out[inside] = value
+    return out
+
+
+def _scale_lut(lut, factor):
+    """Scale the RGB channels of an ARGB32 LUT, dropping alpha"""
+    channels = [(lut >> shift) & 0xFF for shift in (16, 8, 0)]
+    r, g, b = (np.floor(c * factor).astype(np.uint32) for c in channels)
+    return (r << 16) | (g << 8) | b
+
+
+@lru_cache(maxsize=16)
+def blend_luts(base_colormap, overlay_colormap, alpha):
+    """Pre-weighted LUTs whose packed sum is the alpha blend of two colormaps
+
+    Each channel is floored after weighting, so base + overlay never exceeds
+    255 per channel and the packed uint32 add cannot carry between channels.
+    """
+    base = _scale_lut(colormap_lut(base_colormap), 1 - alpha) | np.uint32(0xFF000000)
+    overlay = _scale_lut(colormap_lut(overlay_colormap), alpha)
+    return base, overlay
+
+
+def fuse_indices(base_indices, overlay_indices, overlay_valid, base_colormap, overlay_colormap, alpha):
+    """Single-pass blend of two windowed index frames into an ARGB32 frame"""
+    base_lut, overlay_lut = blend_luts(base_colormap, overlay_colormap, alpha)
+    argb = base_lut[base_indices] + overlay_lut[overlay_indices]
+    if not overlay_valid.all():
+        # Outside of the overlay volume the base shows unblended
+        argb = np.where(overlay_valid, argb, colormap_lut(base_colormap)[base_indices])
+    return argb
+
+
+def indices_to_rgb(indices, colormap="gray"):
+    """Expand windowed indices through a colormap into an (h, w, 3) uint8 image"""
+    argb = colormap_lut(colormap)[indices]
+    return np.stack(
+        [(argb >> 16) & 0xFF, (argb >> 8) & 0xFF, argb & 0xFF], axis=-1
+    ).astype(np.uint8)
+
+
+def render_rgb(slice_data, view_rect, out_w, out_h, window_level, colormap="gray", method="nearest"):
+    """Whole display pipeline of one slice, without any Qt: resample, window, colormap"""
+    frame = resample_slice(slice_data, view_rect, out_w, out_h, method)
+    return indices_to_rgb(window_to_uint8(frame, *window_level), colormap)
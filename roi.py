@@ -0,0 +1,310 @@
+#!/usr/bin/env python
+import os
+import time
+from concurrent.futures import ThreadPoolExecutor
+import numpy as np
+from geometry import PLANE_AXES
+from rendering import frame_volume
+
+ROI_BLOCK = 8  # Edge of the blocks whose partial sums are kept per volume
+ROI_CHUNK_VOXELS = 1 << 22  # Voxels reduced at once outside of the block tables
+ROI_UPDATE_SLABS = 2  # Slabs of changed blocks re-reduced in place, more rebuild in the background
+
+
+class RegionStats:
+    """Count, sum, sum of squares, min and max of a region, mergeable with +
+
+    Non-finite voxels are ignored. Sums are accumulated in float64.
+    """
+
+    __slots__ = ("count", "total", "total_sq", "min", "max")
+
+    def __init__(self, count=0, total=0.0, total_sq=0.0, min=np.inf, max=-np.inf):
+        self.count = int(count)
+        self.total = float(total)
+        self.total_sq = float(total_sq)
+        self.min = float(min)
+        self.max = float(max)
+
+    @classmethod
+    def of(cls, data):
+        data = np.asarray(data)
+        if data.dtype.kind == "f":
+            finite = np.isfinite(data)
+            if not finite.all():
+                data = data[finite]
+        if data.size == 0:
+            return cls()
+        flat = data.astype(np.float64).ravel()
+        return cls(flat.size, flat.sum(), np.dot(flat, flat), flat.min(), flat.max())
+
+    def __add__(self, other):
+        return RegionStats(
+            self.count + other.count,
+            self.total + other.total,
+            self.total_sq + other.total_sq,
+            min(self.min, other.min),
+            max(self.max, other.max),
+        )
+
+    @property
+    def mean(self):
+        return self.total / self.count if self.count else float("nan")
+
+    @property
+    def std(self):
+        if not self.count:
+            return float("nan")
+        return float(np.sqrt(max(self.total_sq / self.count - self.mean**2, 0.0)))
+
+
+def _reduce_blocks(ufunc, plane, y_edges, x_edges):
+    return ufunc.reduceat(ufunc.reduceat(plane, y_edges, axis=0), x_edges, axis=1)
+
+
+def _prefix(table):
+    """Summed-area table of a block table, zero padded on the low side"""
+    prefix = np.zeros(tuple(n + 1 for n in table.shape))
+    prefix[1:, 1:, 1:] = table.cumsum(0).cumsum(1).cumsum(2)
+    return prefix
+
+
+def _prefix_sum(prefix, z0, z1, y0, y1, x0, x1):
+    return (
+        prefix[z1, y1, x1] - prefix[z0, y1, x1] - prefix[z1, y0, x1] - prefix[z1, y1, x0]
+        + prefix[z0, y0, x1] + prefix[z0, y1, x0] + prefix[z1, y0, x0] - prefix[z0, y0, x0]
+    )
+
+
+class BlockTables:
+    """Per-block partial sums of one 3D volume
+
+    The volume is cut into block**3 cubes (smaller at the far edges). Counts,
+    sums and sums of squares are kept as summed-area tables so any box of
+    whole blocks is reduced in constant time; min and max are kept per block.
+    """
+
+    def __init__(self, volume, block=ROI_BLOCK, workers=None):
+        self.block = block
+        self.shape = volume.shape
+        nz = volume.shape[0]
+        z_edges = list(range(0, nz, block))
+
+        # One pass over the voxels, a slab of blocks per task
+        with ThreadPoolExecutor(max_workers=workers or os.cpu_count()) as pool:
+            slabs = list(
+                pool.map(
+                    lambda z: self._reduce_slab(volume, z, min(z + block, nz)), z_edges
+                )
+            )
+        # Per-block (count, total, total_sq, low, high), kept for update()
+        self.blocks = [np.stack(t) for t in zip(*slabs)]
+        self._build_prefixes()
+        self.nbytes = sum(
+            t.nbytes for t in self.blocks + [self.count, self.total, self.total_sq]
+        )
+
+    def _build_prefixes(self):
+        count, total, total_sq, self.low, self.high = self.blocks
+        self.count = _prefix(count)
+        self.total = _prefix(total)
+        self.total_sq = _prefix(total_sq)
+
+    def update(self, volume, z_indices):
+        """Re-reduce the slabs of blocks holding the given (changed) z indices"""
+        nz = self.shape[0]
+        for slab in sorted({int(z) // self.block for z in z_indices}):
+            z0 = slab * self.block
+            for table, values in zip(
+                self.blocks, self._reduce_slab(volume, z0, min(z0 + self.block, nz))
+            ):
+                table[slab] = values
+        self._build_prefixes()
+
+    def _reduce_slab(self, volume, z0, z1):
+        _, ny, nx = self.shape
+        y_edges = np.arange(0, ny, self.block)
+        x_edges = np.arange(0, nx, self.block)
+        block_voxels = np.outer(
+            np.diff(y_edges, append=ny), np.diff(x_edges, append=nx)
+        ).astype(np.float64)
+        count = np.zeros((len(y_edges), len(x_edges)))
+        total = np.zeros_like(count)
+        total_sq = np.zeros_like(count)
+        low = np.full_like(count, np.inf)
+        high = np.full_like(count, -np.inf)
+
+        for z in range(z0, z1):
+            plane = np.asarray(volume[z], dtype=np.float64)
+            finite = np.isfinite(plane)
+            if finite.all():
+                count += block_voxels
+                low_plane = high_plane = plane
+            else:
+                count += _reduce_blocks(np.add, finite.astype(np.float64), y_edges, x_edges)
+                low_plane = np.where(finite, plane, np.inf)
+                high_plane = np.where(finite, plane, -np.inf)
+                plane = np.where(finite, plane, 0.0)
+            total += _reduce_blocks(np.add, plane, y_edges, x_edges)
+            total_sq += _reduce_blocks(np.add, plane * plane, y_edges, x_edges)
+            np.minimum(low, _reduce_blocks(np.minimum, low_plane, y_edges, x_edges), out=low)
+            np.maximum(high, _reduce_blocks(np.maximum, high_plane, y_edges, x_edges), out=high)
+        return count, total, total_sq, low, high
+
+    def blocks_inside(self, ranges):
+        """Block index ranges of the whole blocks inside a ZYX voxel box"""
+        blocks = []
+        for (start, stop), n in zip(ranges, self.shape):
+            first = -(-start // self.block)
+            last = -(-n // self.block) if stop == n else stop // self.block
+            blocks.append((first, last))
+        return blocks
+
+    def stats(self, blocks):
+        (bz0, bz1), (by0, by1), (bx0, bx1) = blocks
+        box = (bz0, bz1, by0, by1, bx0, bx1)
+        region = (slice(bz0, bz1), slice(by0, by1), slice(bx0, bx1))
+        return RegionStats(
+            round(_prefix_sum(self.count, *box)),
+            _prefix_sum(self.total, *box),
+            _prefix_sum(self.total_sq, *box),
+            self.low[region].min(),
+            self.high[region].max(),
+        )
+
+
+def plane_box(orientation, rect, slice_range):
+    """ZYX voxel ranges of an in-plane rect (x_min, x_max, y_min, y_max) over slices"""
+    column_axis, row_axis, slice_axis = PLANE_AXES[orientation]
+    ranges = [None] * 3  # XYZ
+    ranges[column_axis] = (int(rect[0]), int(rect[1]))
+    ranges[row_axis] = (int(rect[2]), int(rect[3]))
+    ranges[slice_axis] = (int(slice_range[0]), int(slice_range[1]))
+    return ranges[::-1]
+
+
+class RoiStats:
+    """ROI statistics of one volume, shared by all of its views
+
+    A box is reduced as the whole blocks it contains, read from the block
+    tables in constant time, plus the shell of partial blocks around them,
+    read from the volume. The cost follows the surface of the box rather
+    than its volume, so moving a large 3D ROI stays interactive. Tables are
+    built per time frame in the background on the first query that can use
+    them; until then boxes are reduced directly.
+    """
+
+    def __init__(self, volume, block=ROI_BLOCK):
+        self.volume = volume
+        self.block = block
+        self._tables = {}  # frame -> BlockTables
+        self._pending = {}  # frame -> Future of BlockTables
+        self.executor = ThreadPoolExecutor(max_workers=1)
+        self.last_used = time.monotonic()
+        self.governor = None  # MemoryGovernor, see memory.py
+
+    @property
+    def nbytes(self):
+        return sum(t.nbytes for t in self._tables.values())
+
+    def evict(self, nbytes):
+        """Drop block tables (rebuilt on demand), return bytes freed"""
+        freed = 0
+        for frame in list(self._tables):
+            if freed >= nbytes:
+                break
+            freed += self._tables.pop(frame).nbytes
+        return freed
+
+    def tables(self, frame=0):
+        """Block tables of a frame, None (and a build is started) if not ready"""
+        tables = self._tables.get(frame)
+        if tables is not None:
+            return tables
+        future = self._pending.get(frame)
+        if future is None:
+            volume = frame_volume(self.volume, frame)
+            self._pending[frame] = self.executor.submit(BlockTables, volume, self.block)
+        elif future.done():
+            self._tables[frame] = tables = self._pending.pop(frame).result()
+            if self.governor is not None:
+                self.governor.trim()
+        return tables
+
+    def update(self, frame, z_indices):
+        """Follow a change of the given z indices of a frame, see BlockTables.update
+
+        Called on the GUI thread: a few changed slabs are re-reduced in place,
+        larger changes drop the tables, rebuilt in the background on demand.
+        """
+        tables = self._tables.get(frame)
+        slabs = {int(z) // self.block for z in z_indices}
+        if tables is None or len(slabs) > ROI_UPDATE_SLABS:
+            self.invalidate(frame)
+        else:
+            tables.update(frame_volume(self.volume, frame), z_indices)
+
+    def invalidate(self, frame=None):
+        for f in list(self._pending) if frame is None else [frame]:
+            future = self._pending.pop(f, None)
+            if future is not None:
+                future.cancel()
+        if frame is None:
+            self._tables.clear()
+        else:
+            self._tables.pop(frame, None)
+
+    def box(self, ranges, frame=0):
+        """RegionStats of a ZYX box ((z0, z1), (y0, y1), (x0, x1))"""
+        self.last_used = time.monotonic()
+        volume = frame_volume(self.volume, frame)
+        ranges = [
+            (max(0, min(a, n)), max(0, min(b, n)))
+            for (a, b), n in zip(ranges, volume.shape)
+        ]
+        if any(b <= a for a, b in ranges):
+            return RegionStats()
+
+        # Single slices never contain a whole block, don't build tables for them
+        if min(b - a for a, b in ranges) >= self.block:
+            tables = self.tables(frame)
+        else:
+            tables = None
+        blocks = tables.blocks_inside(ranges) if tables is not None else None
+        if blocks is None or any(last <= first for first, last in blocks):
+            return self._direct(volume, ranges)
+
+        (z0, z1), (y0, y1), (x0, x1) = ranges
+        (iz0, iz1), (iy0, iy1), (ix0, ix1) = (
+            (first * self.block, min(last * self.block, n))
+            for (first, last), n in zip(blocks, volume.shape)
+        )
+        stats = tables.stats(blocks)
+        for shell in (
+            ((z0, iz0), (y0, y1), (x0, x1)),
+            ((iz1, z1), (y0, y1), (x0, x1)),
+            ((iz0, iz1), (y0, iy0), (x0, x1)),
+            ((iz0, iz1), (iy1, y1), (x0, x1)),
+            ((iz0, iz1), (iy0, iy1), (x0, ix0)),
+            ((iz0, iz1), (iy0, iy1), (ix1, x1)),
+        ):
+            if all(b > a for a, b in shell):
+                stats = stats + self._direct(volume, shell)
+        return stats
+
+    def plane(self, orientation, rect, slice_range, frame=0):
+        """RegionStats of an in-plane rect over a range of slices"""
+        return self.box(plane_box(orientation, rect, slice_range), frame)
+
+    def _direct(self, volume, ranges):
+        """Reduce a box from the voxels, a bounded number of them at a time"""
+        (z0, z1), (y0, y1), (x0, x1) = ranges
+        step = max(1, ROI_CHUNK_VOXELS // ((y1 - y0) * (x1 - x0)))
+        stats = RegionStats()
+        for z in range(z0, z1, step):
+            stats = stats + RegionStats.of(volume[z : min(z + step, z1), y0:y1, x0:x1])
+        return stats
+
+    def shutdown(self):
+        self.invalidate()
+        self.executor.shutdown(wait=False)
@@ -0,0 +1,289 @@
+#!/usr/bin/env python
+import glob
+import hashlib
+import json
+import os
+from concurrent.futures import ThreadPoolExecutor
+import numpy as np
+from rendering import frame_volume, num_frames, volume_range
+
+STATS_VERSION = 2  # Bump when the content of the sidecar changes
+HISTOGRAM_BINS = 256
+SLICE_BINS = 64  # Coarser histograms of every slice, along every axis
+STATS_CHUNK_VOXELS = 1 << 22  # Voxels reduced at once per task
+SLICE_AXES = {0: (1, 2), 1: (0, 2), 2: (0, 1)}  # Orientation -> ZYX axes reduced
+AUTO_WINDOW_PERCENTILES = (1, 99)  # Per-slice auto window
+RANGE_SAMPLE_SLICES = 16  # Slices per frame read for the window shown until stats are ready
+
+
+def _histogram_percentile(histogram, low, high, q):
+    """Value below which q percent of a histogram over [low, high] lies"""
+    total = histogram.sum()
+    if total == 0:
+        return float("nan")
+    cumulative = np.cumsum(histogram)
+    target = q / 100 * total
+    b = int(np.searchsorted(cumulative, target))
+    b = min(b, len(histogram) - 1)
+    before = cumulative[b - 1] if b else 0
+    fraction = (target - before) / histogram[b] if histogram[b] else 0.0
+    return float(low + (b + fraction) * (high - low) / len(histogram))
+
+
+class VolumeStats:
+    """Global and per-slice statistics of one 3D volume (one time frame)
+
+    Global: finite min, max, histogram over [min, max] and percentiles.
+    Per slice of every orientation: min, max, sum, count of finite voxels,
+    count of non-zero voxels and a SLICE_BINS histogram over the same range.
+    Built in two threaded passes over slabs of slices: ranges first, then
+    histograms over the ranges found.
+    """
+
+    ARRAYS = ("min", "max", "sum", "count", "nonzero", "histogram")
+
+    def __init__(self, shape, low, high, histogram, slices):
+        self.shape = tuple(shape)
+        self.low = float(low)
+        self.high = float(high)
+        self.histogram = histogram
+        self.slices = slices  # orientation -> {name: array over the slices}
+
+    @property
+    def range(self):
+        return [self.low, self.high]
+
+    def percentile(self, q):
+        return _histogram_percentile(self.histogram, self.low, self.high, q)
+
+    def slice_percentile(self, orientation, index, q):
+        histogram = self.slices[orientation]["histogram"][index]
+        return _histogram_percentile(histogram, self.low, self.high, q)
+
+    def slice_mean(self, orientation):
+        s = self.slices[orientation]
+        with np.errstate(invalid="ignore", divide="ignore"):
+            return s["sum"] / s["count"]
+
+    def slice_window(self, orientation, index, percentiles=AUTO_WINDOW_PERCENTILES):
+        """Window level of one slice from its percentiles, None for a constant slice"""
+        window = [self.slice_percentile(orientation, index, q) for q in percentiles]
+        if not window[1] > window[0]:
+            return None
+        return window
+
+    def nonempty(self, orientation):
+        """Slices holding more than one value (background-only slices are constant)"""
+        s = self.slices[orientation]
+        return s["max"] > s["min"]
+
+    def next_nonempty(self, orientation, index, step=1):
+        """Next non-empty slice after index, wrapping around, or None if all are empty"""
+        nonempty = self.nonempty(orientation)
+        n = len(nonempty)
+        for offset in range(1, n + 1):
+            candidate = (index + step * offset) % n
+            if nonempty[candidate]:
+                return candidate
+        return None
+
+    @classmethod
+    def compute(cls, volume, frame=0, workers=None):
+        volume = frame_volume(volume, frame)
+        nz, ny, nx = volume.shape
+        step = max(1, STATS_CHUNK_VOXELS // (ny * nx))
+        spans = [(z, min(z + step, nz)) for z in range(0, nz, step)]
+
+        def read(z0, z1):
+            slab = np.asarray(volume[z0:z1], dtype=np.float32)
+            finite = np.isfinite(slab)
+            return slab, (None if finite.all() else finite)
+
+        def ranges(span):
+            slab, finite = read(*span)
+            # fmin/fmax skip the NaNs the non-finite voxels are turned into
+            if finite is not None:
+                slab = np.where(finite, slab, np.nan)
+            values = np.where(np.isnan(slab), 0, slab) if finite is not None else slab
+            counts = finite if finite is not None else np.ones(slab.shape, dtype=bool)
+            return {
+                orientation: (
+                    np.fmin.reduce(slab, axis=axes),
+                    np.fmax.reduce(slab, axis=axes),
+                    values.sum(axis=axes, dtype=np.float64),
+                    counts.sum(axis=axes),
+                    np.count_nonzero(values, axis=axes),
+                )
+                for orientation, axes in SLICE_AXES.items()
+            }
+
+        with ThreadPoolExecutor(max_workers=workers or os.cpu_count()) as pool:
+            partials = list(pool.map(ranges, spans))
+            slices = {}
+            for orientation in SLICE_AXES:
+                parts = [p[orientation] for p in partials]
+                if orientation == 0:  # Slabs hold disjoint z slices
+                    merged = [np.concatenate(t) for t in zip(*parts)]
+                else:
+                    merged = [
+                        np.fmin.reduce([p[0] for p in parts]),
+                        np.fmax.reduce([p[1] for p in parts]),
+                        *(np.sum([p[i] for p in parts], axis=0) for i in (2, 3, 4)),
+                    ]
+                slices[orientation] = dict(zip(cls.ARRAYS, merged))
+            low = np.fmin.reduce(slices[0]["min"]) if nz else np.nan
+            high = np.fmax.reduce(slices[0]["max"]) if nz else np.nan
+            if not np.isfinite(low):
+                low = high = 0.0
+
+            scale = HISTOGRAM_BINS / (high - low) if high > low else 0.0
+            shapes = {0: nz, 1: ny, 2: nx}
+
+            def histograms(span):
+                slab, finite = read(*span)
+                if finite is not None:
+                    slab = np.where(finite, slab, low)
+                bins = np.clip(((slab - low) * scale).astype(np.int64), 0, HISTOGRAM_BINS - 1)
+                if finite is not None:
+                    bins[~finite] = HISTOGRAM_BINS  # Dropped below
+                total = np.bincount(bins.ravel(), minlength=HISTOGRAM_BINS + 1)
+                coarse = np.minimum(bins * SLICE_BINS // HISTOGRAM_BINS, SLICE_BINS)
+                result = {"total": total[:HISTOGRAM_BINS]}
+                columns = SLICE_BINS + 1
+                for orientation, axis in ((0, 0), (1, 1), (2, 2)):
+                    index = np.arange(slab.shape[axis] if orientation else span[1] - span[0])
+                    shape = [1, 1, 1]
+                    shape[axis] = -1
+                    keys = (coarse + index.reshape(shape) * columns).ravel()
+                    counts = np.bincount(keys, minlength=len(index) * columns)
+                    result[orientation] = counts.reshape(-1, columns)[:, :SLICE_BINS]
+                return result
+
+            parts = list(pool.map(histograms, spans))
+        histogram = np.sum([p["total"] for p in parts], axis=0)
+        slices[0]["histogram"] = np.concatenate([p[0] for p in parts])
+        for orientation in (1, 2):
+            slices[orientation]["histogram"] = np.sum([p[orientation] for p in parts], axis=0)
+        assert all(len(slices[o]["min"]) == shapes[o] for o in shapes)
+        return cls((nz, ny, nx), low, high, histogram, slices)
+
+    def arrays(self, prefix):
+        """Flat {name: array} of everything, for np.savez"""
+        arrays = {
+            prefix + "shape": np.array(self.shape),
+            prefix + "range": np.array([self.low, self.high]),
+            prefix + "histogram": self.histogram,
+        }
+        for orientation, values in self.slices.items():
+            for name, array in values.items():
+                arrays[f"{prefix}{orientation}_{name}"] = array
+        return arrays
+
+    @classmethod
+    def from_arrays(cls, arrays, prefix):
+        low, high = arrays[prefix + "range"]
+        slices = {
+            orientation: {name: arrays[f"{prefix}{orientation}_{name}"] for name in cls.ARRAYS}
+            for orientation in SLICE_AXES
+        }
+        return cls(arrays[prefix + "shape"], low, high, arrays[prefix + "histogram"], slices)
+
+
+def compute_stats(volume, workers=None):
+    """{frame: VolumeStats} of every frame of a volume"""
+    return {frame: VolumeStats.compute(volume, frame, workers) for frame in range(num_frames(volume))}
+
+
+def sampled_range(volume, slices=RANGE_SAMPLE_SLICES):
+    """[min, max] of a few evenly spaced slices of the frames rendering.volume_range reads
+
+    A first window while the statistics are computed, so a volume opened
+    without a sidecar is not scanned once for its range and twice for them.
+    """
+    if hasattr(volume, "estimate_range"):
+        return volume_range(volume)
+    nt = num_frames(volume)
+    low, high = np.inf, -np.inf
+    for frame in range(0, nt, max(1, nt // 4)):
+        data = frame_volume(volume, frame)
+        for z in np.unique(np.linspace(0, data.shape[0] - 1, slices).astype(int)):
+            plane = np.asarray(data[z], dtype=np.float32)
+            plane = plane[np.isfinite(plane)]
+            if plane.size:
+                low, high = min(low, float(plane.min())), max(high, float(plane.max()))
+    return [low, high] if low <= high else [0.0, 0.0]
+
+
+def stats_range(stats):
+    """[min, max] over the frames of {frame: VolumeStats}"""
+    return [min(s.low for s in stats.values()), max(s.high for s in stats.values())]
+
+
+def sidecar_dir():
+    base = os.environ.get("XDG_CACHE_HOME") or os.path.join(os.path.expanduser("~"), ".cache")
+    return os.path.join(base, "interdit", "stats")
+
+
+def source_key(filename, options=None):
+    """Identity of the data behind a filename: path, size, mtime and load options
+
+    options (e.g. storage, crop, bin) are whatever changes the loaded data.
+    A glob (e.g. of DICOM files) is keyed on all the files it matches.
+    """
+    paths = sorted(glob.glob(filename)) if glob.has_magic(filename) else [filename]
+    stats = [os.stat(p) for p in paths]
+    return json.dumps(
+        {
+            "version": STATS_VERSION,
+            "path": os.path.abspath(filename),
+            "size": sum(s.st_size for s in stats),
+            "mtime": max((s.st_mtime_ns for s in stats), default=0),
+            "options": options,
+        },
+        default=str,
+    )
+
+
+def sidecar_path(filename, options=None):
+    name = json.dumps([os.path.abspath(filename), options], default=str)
+    digest = hashlib.sha1(name.encode()).hexdigest()
+    return os.path.join(sidecar_dir(), digest + ".npz")
+
+
+def load_sidecar(filename, shape, options=None):
+    """{frame: VolumeStats} stored for this exact file, None if absent or stale"""
+    try:
+        with np.load(sidecar_path(filename, options)) as arrays:
+            if str(arrays["key"]) != source_key(filename, options):
+                return None
+            if tuple(arrays["shape"]) != tuple(shape):
+                return None
+            return {
+                int(frame): VolumeStats.from_arrays(arrays, f"f{frame}_")
+                for frame in arrays["frames"]
+            }
+    except (OSError, KeyError, ValueError):
+        return None
+
+
+def save_sidecar(filename, shape, stats, options=None, key=None):
+    """Store {frame: VolumeStats} of a file, replacing the previous sidecar atomically
+
+    key is the source_key of the file taken before the statistics were
+    computed, so a file rewritten meanwhile does not get them as its own.
+    """
+    arrays = {
+        "key": np.array(key or source_key(filename, options)),
+        "shape": np.array(shape),
+        "frames": np.array(sorted(stats)),
+    }
+    for frame, frame_stats in stats.items():
+        arrays.update(frame_stats.arrays(f"f{frame}_"))
+    path = sidecar_path(filename, options)
+    try:
+        os.makedirs(os.path.dirname(path), exist_ok=True)
+        temporary = f"{path}.{os.getpid()}.tmp.npz"
+        np.savez(temporary, **arrays)
+        os.replace(temporary, path)
+    except OSError as e:
+        print(f"Warning: could not write the statistics of {filename}: {e}")
@@ -0,0 +1,183 @@
+#!/usr/bin/env python
+import os
+from concurrent.futures import ThreadPoolExecutor
+import numpy as np
+
+STORAGES = ("f16", "u16q")
+STORAGE_CHUNK_VOXELS = 1 << 22  # Voxels converted at once per task
+U16_LEVELS = 65535
+
+
+class QuantizedArray:
+    """Array stored as uint16 codes, read as float32 code * slope + intercept
+
+    Indexing that keeps 2 or more dimensions returns another QuantizedArray
+    over the codes, so slices and regions stay compact until a kernel reads
+    them with np.asarray (every kernel reads its input that way). Smaller
+    results are decoded at once.
+
+    Codes have no room for non-finite values: NaN is stored as code 0 and
+    reads back as intercept (the minimum of the range), -inf and +inf as
+    the minimum and maximum.
+    """
+
+    def __init__(self, codes, slope, intercept):
+        self.codes = codes
+        self.slope = float(slope)
+        self.intercept = float(intercept)
+
+    shape = property(lambda self: self.codes.shape)
+    ndim = property(lambda self: self.codes.ndim)
+    nbytes = property(lambda self: self.codes.nbytes)
+    dtype = np.dtype(np.float32)
+
+    def __len__(self):
+        return len(self.codes)
+
+    def decode(self, codes, dtype=np.float32):
+        values = codes.astype(dtype)
+        values *= dtype(self.slope)
+        values += dtype(self.intercept)
+        return values
+
+    def encode(self, values):
+        codes = np.rint((np.asarray(values, dtype=np.float32) - self.intercept) / self.slope)
+        return np.clip(np.nan_to_num(codes, copy=False), 0, U16_LEVELS).astype(np.uint16)
+
+    def __setitem__(self, key, values):
+        """Store values, quantized with this array's slope and intercept"""
+        self.codes[key] = self.encode(values)
+
+    def __getitem__(self, key):
+        codes = self.codes[key]
+        if np.ndim(codes) >= 2:
+            return QuantizedArray(codes, self.slope, self.intercept)
+        return self.decode(np.asarray(codes))
+
+    def __array__(self, dtype=None, copy=None):
+        return self.decode(self.codes, np.dtype(dtype or np.float32).type)
+
+    def contiguous(self):
+        return QuantizedArray(np.ascontiguousarray(self.codes), self.slope, self.intercept)
+
+    def estimate_range(self):
+        """Exact (min, max), read from the codes"""
+        return [float(v) for v in self.decode(np.array([self.codes.min(), self.codes.max()]))]
+
+
+def storage_kind(volume):
+    """"f16" or "u16q" if a volume, or an input of a derived one, is held in
+    a reduced precision form, else None"""
+    if isinstance(volume, QuantizedArray):
+        return "u16q"
+    if getattr(volume, "dtype", None) == np.float16:
+        return "f16"
+    for source in getattr(volume, "inputs", ()):
+        kind = storage_kind(source)
+        if kind is not None:
+            return kind
+    return None
+
+
+def _parallel(volume, fn, workers=None):
+    """fn(slab, i0, i1) over runs of slices i0:i1 (all leading axes flattened)
+
+    Runs stay within one time frame and each is read as a contiguous slab,
+    so a non-contiguous volume (e.g. a transposed view) is never copied whole.
+    """
+    nz = volume.shape[-3]
+    step = max(1, STORAGE_CHUNK_VOXELS // max(1, volume.shape[-2] * volume.shape[-1]))
+    spans = [
+        (t, z, min(z + step, nz))
+        for t in range(volume.shape[0] if volume.ndim == 4 else 1)
+        for z in range(0, nz, step)
+    ]
+
+    def run(span):
+        t, z0, z1 = span
+        frame = volume[t] if volume.ndim == 4 else volume
+        return fn(np.ascontiguousarray(frame[z0:z1]), t * nz + z0, t * nz + z1)
+
+    # Spans are independent, results come back in span order
+    with ThreadPoolExecutor(max_workers=workers or os.cpu_count()) as pool:
+        return list(pool.map(run, spans))
+
+
+class QuantizationError:
+    """Maximum and RMS absolute error of a conversion, over finite voxels"""
+
+    def __init__(self, max_error=0.0, sum_sq=0.0, count=0):
+        self.max_error = max_error
+        self.sum_sq = sum_sq
+        self.count = count
+
+    def __add__(self, other):
+        return QuantizationError(
+            max(self.max_error, other.max_error),
+            self.sum_sq + other.sum_sq,
+            self.count + other.count,
+        )
+
+    @property
+    def rms(self):
+        return float(np.sqrt(self.sum_sq / self.count)) if self.count else 0.0
+
+    @classmethod
+    def between(cls, original, converted):
+        error = np.abs(converted - original, dtype=np.float64).ravel()
+        finite = np.isfinite(original).ravel()
+        if not finite.all():
+            error = error[finite]
+        if error.size == 0:
+            return cls()
+        return cls(float(error.max()), float(np.dot(error, error)), error.size)
+
+
+def convert_volume(volume, storage, workers=None):
+    """Convert a volume to "f16" or "u16q" storage in one parallel pass
+
+    Returns (compact volume, QuantizationError). Each task converts a run of
+    slices and measures the error of its own voxels.
+    """
+    if storage not in STORAGES:
+        raise ValueError(f"Unknown storage {storage!r}, expected one of {STORAGES}")
+    shape = volume.shape
+
+    if storage == "f16":
+        out = np.empty(shape, dtype=np.float16)
+        flat_out = out.reshape(-1, *shape[-2:])
+
+        def convert(original, i0, i1):
+            flat_out[i0:i1] = original
+            return QuantizationError.between(original, flat_out[i0:i1].astype(original.dtype))
+
+        errors = _parallel(volume, convert, workers)
+        return out, sum(errors, QuantizationError())
+
+    # Range of the finite voxels first, so every task quantizes with the same
+    # slope and intercept; NaN and infinities are stored as described in QuantizedArray
+    def bounds(region, i0, i1):
+        finite = region[np.isfinite(region)]
+        return (finite.min(), finite.max()) if finite.size else (np.inf, -np.inf)
+
+    ranges = _parallel(volume, bounds, workers)
+    low = float(min(r[0] for r in ranges))
+    high = float(max(r[1] for r in ranges))
+    if low > high:  # No finite voxel at all
+        low = high = 0.0
+    slope = (high - low) / U16_LEVELS if high > low else 1.0
+    quantized = QuantizedArray(np.empty(shape, dtype=np.uint16), slope, low)
+    flat_codes = quantized.codes.reshape(-1, *shape[-2:])
+
+    def quantize(slab, i0, i1):
+        original = np.asarray(slab, dtype=np.float32)
+        codes = np.clip(original, np.float32(low), np.float32(high))
+        codes -= np.float32(low)
+        codes /= np.float32(slope)
+        np.rint(codes, out=codes)
+        np.clip(np.nan_to_num(codes, copy=False), 0, U16_LEVELS, out=codes)
+        flat_codes[i0:i1] = codes
+        return QuantizationError.between(original, quantized.decode(flat_codes[i0:i1]))
+
+    errors = _parallel(volume, quantize, workers)
+    return quantized, sum(errors, QuantizationError())
@@ -0,0 +1,138 @@
+#!/usr/bin/env python
+import json
+import os
+import socket
+import sys
+import threading
+from concurrent.futures import Future
+import numpy as np
+from PyQt5.QtCore import QObject, QTimer, pyqtSignal
+from geometry import ImageGeometry
+from loading import empty_shared
+
+STREAM_HEADER_BYTES = 1 << 16  # Longest accepted header line
+STREAM_NOTIFY_MS = 30  # Arrivals are reported to the GUI at most this often
+
+
+def open_source(source):
+    """Unbuffered binary reader of "-" (stdin) or "unix:PATH"
+
+    For a Unix socket the viewer listens on PATH and accepts one producer.
+    """
+    if source == "-":
+        return sys.stdin.buffer.raw
+    if source.startswith("unix:"):
+        path = source[len("unix:") :]
+        if os.path.exists(path):
+            os.unlink(path)
+        server = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        server.bind(path)
+        server.listen(1)
+        print(f"Waiting for a producer on {path}")
+        connection, _ = server.accept()
+        server.close()
+        return connection.makefile("rb", buffering=0)
+    raise ValueError(f"Unknown stream source {source!r}, expected - or unix:PATH")
+
+
+def _read_header(reader):
+    line = bytearray()
+    while not line.endswith(b"\n"):
+        byte = reader.read(1)
+        if not byte:
+            raise EOFError("Stream closed before its header")
+        line += byte
+        if len(line) > STREAM_HEADER_BYTES:
+            raise ValueError("Stream header line too long")
+    return json.loads(line)
+
+
+class VolumeStream(QObject):
+    """A preallocated volume filled by a producer in a background thread
+
+    The producer writes one JSON header line, then the raw C-order slices:
+
+        {"shape": [nz, ny, nx], "dtype": "float32", "spacing": [sx, sy, sz]}
+
+    shape may be [nt, nz, ny, nx] for a time series; spacing and origin
+    (XYZ) are optional. Any script writing this can stand in as the source.
+
+    ready resolves to (volume, geometry) as soon as the header is read, so
+    the viewer opens before any slice arrives. Slices are read straight into
+    the volume with readinto, without intermediate copies. received reports
+    the range of slices (all leading axes flattened) that arrived since the
+    last report, so a fast producer does not flood the GUI.
+    """
+
+    received = pyqtSignal(int, int)  # (first, stop) flattened slice indices
+    _arrived = pyqtSignal()
+
+    def __init__(self, source, shared=False, parent=None):
+        super().__init__(parent)
+        self.source = source
+        self.shared = shared  # Allocate in shared memory, for render processes
+        self.ready = Future()
+        self.count = 0  # Slices completely received
+        self.total = None  # Slices in the stream, known from its header
+        self.reported = 0
+        self.range = None  # (min, max) of the finite values received
+        self.notify_timer = QTimer(self)
+        self.notify_timer.setSingleShot(True)
+        self.notify_timer.setInterval(STREAM_NOTIFY_MS)
+        self.notify_timer.timeout.connect(self._report)
+        self._arrived.connect(self._schedule_report)
+        self.thread = threading.Thread(target=self._run, daemon=True)
+        self.thread.start()
+
+    def _run(self):
+        try:
+            reader = open_source(self.source)
+            header = _read_header(reader)
+            shape = tuple(int(n) for n in header["shape"])
+            dtype = np.dtype(header.get("dtype", "float32"))
+            if len(shape) not in (3, 4):
+                raise ValueError(f"Stream shape {shape} is neither ZYX nor TZYX")
+            volume = empty_shared(shape, dtype) if self.shared else np.zeros(shape, dtype)
+            geometry = None
+            if "spacing" in header or "origin" in header:
+                geometry = ImageGeometry(header.get("spacing"), header.get("origin"))
+        except Exception as e:
+            self.ready.set_exception(e)
+            return
+        slices = volume.reshape(-1, *shape[-2:])
+        self.total = len(slices)
+        self.ready.set_result((volume, geometry))
+
+        buffer = memoryview(slices).cast("B")
+        slice_bytes = slices[0].nbytes
+        for index in range(len(slices)):
+            view = buffer[index * slice_bytes : (index + 1) * slice_bytes]
+            filled = 0
+            while filled < slice_bytes:
+                n = reader.readinto(view[filled:])
+                if not n:
+                    print(f"Stream {self.source} ended after {index} of {len(slices)} slices")
+                    self._arrived.emit()
+                    return
+                filled += n
+            finite = slices[index][np.isfinite(slices[index])]
+            if finite.size:
+                low, high = float(finite.min()), float(finite.max())
+                if self.range is not None:
+                    low, high = min(low, self.range[0]), max(high, self.range[1])
+                self.range = (low, high)
+            self.count = index + 1
+            self._arrived.emit()
+
+    @property
+    def complete(self):
+        return self.total is not None and self.count == self.total
+
+    def _schedule_report(self):
+        if not self.notify_timer.isActive():
+            self.notify_timer.start()
+
+    def _report(self):
+        first, self.reported = self.reported, self.count
+        if self.reported > first:
+            self.received.emit(first, self.reported)
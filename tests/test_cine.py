@@ -0,0 +1,48 @@
+#!/usr/bin/env python
+import os
+import sys
+import unittest
+import numpy as np
+
+os.environ.setdefault("QT_QPA_PLATFORM", "offscreen")
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from PyQt5.QtCore import QEventLoop, QTimer
+from viewer import VolumeViewerManager
+
+
+def wait(ms):
+    loop = QEventLoop()
+    QTimer.singleShot(ms, loop.quit)
+    loop.exec_()
+
+
+class CineTest(unittest.TestCase):
+    def test_failing_job_stops_playback(self):
+        """An exception in a frame job stops the cine and shows in the status bar"""
+        manager = VolumeViewerManager([np.random.rand(10, 20, 30).astype(np.float32)])
+        viewer = manager.viewers[0]
+
+        def make_job(index):
+            def job():
+                raise MemoryError("out of memory")
+
+            return job
+
+        viewer.slice_cine.make_job = make_job
+        viewer.slice_play_btn.setChecked(True)
+        for _ in range(20):
+            wait(100)
+            if not viewer.slice_cine.is_playing():
+                break
+        self.assertFalse(viewer.slice_cine.is_playing())
+        self.assertFalse(viewer.slice_play_btn.isChecked())
+        self.assertEqual(
+            viewer.statusBar().currentMessage(), "Cine stopped: MemoryError: out of memory"
+        )
+        for viewer in list(manager.viewers):
+            viewer.close()
+
+
+if __name__ == "__main__":
+    unittest.main()
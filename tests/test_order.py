@@ -0,0 +1,43 @@
+#!/usr/bin/env python
+import os
+import sys
+import unittest
+from concurrent.futures import Future
+import numpy as np
+
+os.environ.setdefault("QT_QPA_PLATFORM", "offscreen")
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from PyQt5.QtWidgets import QApplication
+from viewer import VolumeViewerManager
+
+
+class InputOrderTest(unittest.TestCase):
+    def test_sync_reference_follows_command_line(self):
+        """Inputs finishing out of order keep their command line names and sync reference"""
+        futures = [Future(), Future()]
+        manager = VolumeViewerManager(futures, geometries=[None, None])
+        first = np.zeros((10, 20, 30), np.float32)
+        second = np.ones((10, 20, 30), np.float32)
+        futures[1].set_result((second, None))
+        QApplication.processEvents()
+        futures[0].set_result((first, None))
+        QApplication.processEvents()
+
+        a, b = manager.inputs
+        self.assertIs(a.volume, first)
+        self.assertEqual(manager.viewers, [b, a])
+        self.assertEqual(manager._ordered_viewers(), [a, b])
+
+        manager.sync_control.slice_sync.setChecked(False)
+        a.scrollbar.setValue(3)
+        b.scrollbar.setValue(7)
+        manager.sync_control.slice_sync.setChecked(True)
+        self.assertEqual(b.current_slice, 3)
+        self.assertEqual(a.current_slice, 3)
+        for viewer in list(manager.viewers):
+            viewer.close()
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,40 @@
+#!/usr/bin/env python
+import os
+import sys
+import unittest
+import numpy as np
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from storage import convert_volume
+
+
+class QuantizedStorageTest(unittest.TestCase):
+    def test_non_finite_voxels(self):
+        volume = np.linspace(-2, 3, 4 * 5 * 6, dtype=np.float32).reshape(4, 5, 6)
+        volume[1, 2, 3] = np.nan
+        volume[2, 0, 0] = np.inf
+        volume[3, 4, 5] = -np.inf
+        quantized, error = convert_volume(volume, "u16q")
+        decoded = np.asarray(quantized)
+
+        finite = np.isfinite(volume)
+        self.assertTrue(np.isfinite(decoded).all())
+        np.testing.assert_allclose(decoded[finite], volume[finite], atol=(5 / 65535))
+        self.assertAlmostEqual(decoded[1, 2, 3], quantized.intercept)  # NaN
+        self.assertAlmostEqual(decoded[2, 0, 0], volume[finite].max(), places=5)  # +inf
+        self.assertAlmostEqual(decoded[3, 4, 5], volume[finite].min(), places=5)  # -inf
+        self.assertTrue(np.isfinite(error.rms))
+        self.assertLess(error.max_error, 5 / 65535)
+
+    def test_no_finite_voxel(self):
+        volume = np.full((2, 3, 4), np.nan, dtype=np.float32)
+        volume[0] = np.inf
+        quantized, error = convert_volume(volume, "u16q")
+        self.assertEqual((quantized.slope, quantized.intercept), (1.0, 0.0))
+        np.testing.assert_array_equal(np.asarray(quantized), 0)
+        self.assertEqual(error.count, 0)
+
+
+if __name__ == "__main__":
+    unittest.main()
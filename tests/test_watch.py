@@ -0,0 +1,44 @@
+#!/usr/bin/env python
+import os
+import sys
+import tempfile
+import unittest
+import numpy as np
+
+os.environ.setdefault("QT_QPA_PLATFORM", "offscreen")
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from PyQt5.QtCore import QEventLoop, QTimer
+from viewer import VolumeViewerManager
+
+
+def wait(ms):
+    loop = QEventLoop()
+    QTimer.singleShot(ms, loop.quit)
+    loop.exec_()
+
+
+class WatchTest(unittest.TestCase):
+    def test_rewrite_reaches_viewer(self):
+        """A rewritten file is picked up through the manager, not only a bare VolumeWatcher"""
+        with tempfile.TemporaryDirectory() as directory:
+            path = os.path.join(directory, "volume.npy")
+            data = np.random.rand(10, 20, 30).astype(np.float32)
+            np.save(path, data)
+            manager = VolumeViewerManager([data.copy()], watch=[(path, "npy", None, None, 1)])
+            volume = manager.viewers[0].volume
+            wait(300)  # Initial checksums
+
+            data[5] += 10
+            np.save(path, data)
+            for _ in range(50):
+                wait(100)
+                if volume[5].max() > 10:
+                    break
+            np.testing.assert_array_equal(volume, data)
+            for viewer in list(manager.viewers):
+                viewer.close()
+
+
+if __name__ == "__main__":
+    unittest.main()
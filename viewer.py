@@ -1,5 +1,6 @@
 #! /usr/bin/env python
 import sys
+from concurrent.futures import Future, ThreadPoolExecutor
 import numpy as np
 from PyQt5.QtWidgets import (
     QApplication,
@@ -15,13 +16,159 @@ from PyQt5.QtWidgets import (
     QCheckBox,
     QSizePolicy,
     QDialog,
+    QGridLayout,
+    QComboBox,
+    QSlider,
+    QDoubleSpinBox,
+    QSpinBox,
 )
-from PyQt5.QtGui import QImage, QPixmap, QPainter, QColor, QMouseEvent
-from PyQt5.QtCore import Qt, QPoint, QRectF, pyqtSignal, QPointF
+from PyQt5.QtGui import QImage, QPixmap, QPainter, QColor, QMouseEvent, QPen, QPolygonF
+from PyQt5.QtCore import Qt, QObject, QPoint, QRectF, pyqtSignal, QPointF, QTimer
+from rendering import (
+    COLORMAPS,
+    INTERPOLATIONS,
+    SliceCache,
+    TileCache,
+    colormap_lut,
+    extract_slice,
+    frame_volume,
+    fuse_indices,
+    num_frames,
+    num_slices,
+    plane_sample_points,
+    resample_slice,
+    sample_line,
+    sample_volume,
+    slice_shape,
+    volume_range,
+    voxel_value,
+    window_to_uint8,
+)
+from derived import ExpressionVolume, compare_volumes, parse_expression
+from cine import CinePlayer
+from roi import RoiStats, plane_box
+from hotspot import HOTSPOT_PEAKS, HOTSPOT_RADIUS, find_peaks
+from memory import MemoryGovernor
+from storage import storage_kind
+from loading import share_volume
+from render_worker import RenderWorker
+from watch import VolumeChanges, VolumeWatcher
+from stats import compute_stats, load_sidecar, sampled_range, save_sidecar, source_key, stats_range
+from geometry import (
+    PLANE_AXES,
+    ImageGeometry,
+    fit_to_canvas,
+    index_transform,
+    plane_point,
+)
+
 
-# TODO: The display should always take the size of the frame
-#  if the window is resized, the display should refresh without
-#  needing to click reset and losing the view
+class ImageCanvas(QLabel):
+    """QLabel showing a rendered slice, with overlays painted on top
+
+    Overlays are callables taking a QPainter. They are repainted without
+    touching the underlying pixmap, so moving a crosshair or a marker does
+    not require re-rendering the slice.
+    """
+
+    def __init__(self, parent=None):
+        super().__init__(parent)
+        self.overlays = {}
+
+    def set_overlay(self, name, paint_fn, dirty=None):
+        """Add, replace or (with None) remove an overlay
+
+        dirty limits the repaint to a QRect covering both the old and the new
+        overlay, for overlays that move with the mouse.
+        """
+        if paint_fn is None:
+            self.overlays.pop(name, None)
+        else:
+            self.overlays[name] = paint_fn
+        if dirty is None:
+            self.update()
+        else:
+            self.update(dirty)
+
+    def pixmap_rect(self):
+        """Rectangle of the displayed pixmap in widget coordinates"""
+        pixmap = self.pixmap()
+        if pixmap is None or pixmap.isNull():
+            return QRectF(0, 0, self.width(), self.height())
+        pw = pixmap.width() / pixmap.devicePixelRatioF()
+        ph = pixmap.height() / pixmap.devicePixelRatioF()
+        return QRectF((self.width() - pw) / 2, (self.height() - ph) / 2, pw, ph)
+
+    def paintEvent(self, event):
+        super().paintEvent(event)
+        if not self.overlays:
+            return
+        painter = QPainter(self)
+        for paint_fn in self.overlays.values():
+            paint_fn(painter)
+        painter.end()
+
+
+class SliceProfile(QWidget):
+    """Miniature per-slice intensity profile drawn alongside the slice scrollbar
+
+    One row per slice, top to bottom like the scrollbar: a bar for the mean
+    and a tick for the max, scaled to the volume range. Empty slices are
+    left blank and the current slice is marked. Clicking jumps to a slice.
+    """
+
+    slice_clicked = pyqtSignal(int)
+
+    def __init__(self, parent=None):
+        super().__init__(parent)
+        self.means = None
+        self.maxima = None
+        self.nonempty = None
+        self.current = 0
+        self.setFixedWidth(24)
+
+    def set_profile(self, stats, orientation):
+        """Show the slices of an orientation from stats.VolumeStats (None clears)"""
+        if stats is None:
+            self.means = self.maxima = self.nonempty = None
+        else:
+            scale = stats.high - stats.low or 1.0
+            self.means = np.nan_to_num((stats.slice_mean(orientation) - stats.low) / scale)
+            self.maxima = np.nan_to_num((stats.slices[orientation]["max"] - stats.low) / scale)
+            self.nonempty = stats.nonempty(orientation)
+        self.update()
+
+    def set_current(self, index):
+        self.current = index
+        self.update()
+
+    def _row(self, y):
+        return int(clamp(y / max(self.height(), 1) * len(self.means), 0, len(self.means) - 1))
+
+    def mousePressEvent(self, event):
+        if self.means is not None:
+            self.slice_clicked.emit(self._row(event.pos().y()))
+
+    def paintEvent(self, event):
+        painter = QPainter(self)
+        painter.fillRect(self.rect(), QColor(20, 20, 20))
+        if self.means is None:
+            painter.end()
+            return
+        n = len(self.means)
+        width, row_height = self.width(), self.height() / n
+        for index in np.flatnonzero(self.nonempty):
+            top = index * row_height
+            painter.fillRect(
+                QRectF(0, top, self.means[index] * width, max(row_height, 1)), QColor(90, 140, 200)
+            )
+            painter.fillRect(
+                QRectF(self.maxima[index] * width - 1, top, 2, max(row_height, 1)), QColor(230, 230, 230)
+            )
+        painter.fillRect(
+            QRectF(0, self.current * row_height, width, max(row_height, 2)), QColor(255, 200, 0)
+        )
+        painter.end()
 
 
 class VolumeViewer(QMainWindow):
@@ -29,19 +176,95 @@ class VolumeViewer(QMainWindow):
     view_rect_changed = pyqtSignal(tuple)
     slice_changed = pyqtSignal(int)
     orientation_changed = pyqtSignal(int)
-
-    def __init__(self, volume_data):
+    frame_changed = pyqtSignal(int)
+    slice_playback_toggled = pyqtSignal(bool)
+    hover_changed = pyqtSignal(object)  # XYZ index under the cursor, None on leave
+    profile_line_changed = pyqtSignal(object)  # (start, end) XYZ indices, or None
+    profile_updated = pyqtSignal()  # self.profile was re-sampled or cleared
+    closed = pyqtSignal()
+
+    # Adaptive interpolation: nearest while interacting, this once idle
+    ADAPTIVE_QUALITY = "bicubic"
+    ADAPTIVE_IDLE_MS = 150
+    # Resizing stretches the current frame, it is re-rendered once settled
+    RESIZE_SETTLE_MS = 120
+
+    def __init__(self, volume_data, slice_cache=None, geometry=None, roi_stats=None, stats=None, window_level=None):
         super().__init__()
         self.volume = volume_data
+        self.stats = stats  # {frame: stats.VolumeStats}, saves the scan for the window
+        self.slice_cache = slice_cache or SliceCache(volume_data)
+        self.geometry = geometry or ImageGeometry()
+        self.roi_stats = roi_stats or RoiStats(volume_data)
         volume_shape = self.volume.shape
         self.nx, self.ny, self.nz = volume_shape[-1], volume_shape[-2], volume_shape[-3]
+        self.nt = num_frames(self.volume)  # Time frames of a TZYX series, else 1
+        self.current_frame = 0
         self.current_slice = 0
         self.orientation = 0  # 0=XY, 1=XZ, 2=YZ
-        self.window_level = [np.min(self.volume), np.max(self.volume)]
+        self.window_level = window_level or (stats_range(stats) if stats else volume_range(self.volume))
+        self.auto_window = False  # Window each slice from its statistics
+        self._manual_window = None  # Window level restored when auto window stops
+        # Hotspot search results [(value, XYZ)], stepped through by find_hotspot
+        self.peaks = None
+        self._peaks_key = None  # Frame, peak count and view state the peaks are stepped from
+        self.peak_index = 0
         self.view_rect = None  # (x_min, x_max, y_min, y_max) in image coordinates
         self.dragging = False
         self.drag_start_pos = None
         self.last_pixmap_info = None  # (pixmap_rect, image_rect)
+        self.interpolation = "nearest"  # One of INTERPOLATIONS or "adaptive"
+        self._render_high_quality = False
+        self.colormap = "gray"
+        self.color_table = colormap_lut(self.colormap).tolist()
+        # Last resampled float frame and its windowed indices, with their keys
+        self._frame_key = None
+        self._frame = None
+        self._indices_key = None
+        self._indices = None
+        self._indices_rect = None  # View rect the indices were rendered for
+        self.tile_cache = TileCache()
+        self.render_worker = None  # RenderWorker process, see set_render_worker
+        self._requested_key = None  # Indices key of the frame asked to the worker
+        # Fusion overlay, see set_fusion_overlay
+        self.overlay = None
+        self.overlay_geometry = None
+        self.overlay_transform = None  # Base index -> overlay index affine
+        self.overlay_window_level = None
+        self.overlay_colormap = "hot"
+        self.overlay_alpha = 0.5
+        self._overlay_indices_key = None
+        self._overlay_indices = None
+        self._overlay_valid = None
+        # ROI (x_min, x_max, y_min, y_max) on the current orientation, see set_roi
+        self.roi_rect = None
+        self.roi_drag_start = None  # ROI being moved, as it was when grabbed
+        # Hover readout, see set_hover
+        self.hover_point = None
+        self._hover_dirty = None  # Canvas region of the drawn readout
+        # Line profile, see set_profile_line
+        self.profile_line = None
+        self.profile = None  # (distances, values) sampled along profile_line
+        self.profile_grab = None  # Endpoint (0 or 1) being dragged
+        self.idle_timer = QTimer(self)
+        self.idle_timer.setSingleShot(True)
+        self.idle_timer.setInterval(self.ADAPTIVE_IDLE_MS)
+        self.idle_timer.timeout.connect(self._render_idle)
+        self.resize_timer = QTimer(self)
+        self.resize_timer.setSingleShot(True)
+        self.resize_timer.setInterval(self.RESIZE_SETTLE_MS)
+        self.resize_timer.timeout.connect(self.update_display)
+        self._pixmap = None  # Last rendered pixmap, before any stretching
+        # Cine playback through the time frames
+        self.cine = CinePlayer(self._cine_job, self.nt)
+        self.cine.frame_ready.connect(self._show_cine_frame)
+        self.cine.stats_changed.connect(self._show_cine_stats)
+        self.cine.failed.connect(self._cine_failed)
+        # Cine playback through the slices of the current orientation
+        self.slice_cine = CinePlayer(self._slice_cine_job, self.nz)
+        self.slice_cine.frame_ready.connect(self._show_slice_cine_frame)
+        self.slice_cine.stats_changed.connect(self._show_slice_cine_stats)
+        self.slice_cine.failed.connect(self._slice_cine_failed)
         self.initUI()
 
         self.min_input.editingFinished.connect(self._emit_intensity_changed)
@@ -76,16 +299,56 @@ class VolumeViewer(QMainWindow):
         self.zoom_btn = QPushButton("Zoom", checkable=True)
         self.drag_btn = QPushButton("Drag", checkable=True)
         self.reset_btn = QPushButton("Reset")
+        self.roi_btn = QPushButton("ROI", checkable=True)
+        self.line_btn = QPushButton("Line", checkable=True)
+        self.tool_btns = (self.zoom_btn, self.drag_btn, self.roi_btn, self.line_btn)
         self.min_input = QLineEdit(str(self.window_level[0]))
         self.max_input = QLineEdit(str(self.window_level[1]))
         self.xy_radio = QRadioButton("XY")
         self.xz_radio = QRadioButton("XZ")
         self.yz_radio = QRadioButton("YZ")
+        self.interp_combo = QComboBox()
+        self.interp_combo.addItems(
+            [m.capitalize() for m in INTERPOLATIONS] + ["Adaptive"]
+        )
+        self.colormap_combo = QComboBox()
+        self.colormap_combo.addItems([name.capitalize() for name in COLORMAPS])
+        self.slice_play_btn = QPushButton("Cine", checkable=True)
+        self.slice_fps_input = QDoubleSpinBox()
+        self.slice_fps_input.setRange(0.5, 120)
+        self.slice_fps_input.setValue(self.slice_cine.fps)
+        self.slice_fps_input.setSuffix(" fps")
+        self.auto_window_btn = QPushButton("Auto window", checkable=True)
+        self.auto_window_btn.setToolTip("Window each slice to its own 1-99th percentiles")
+        self.next_nonempty_btn = QPushButton("Next non-empty")
+        self.next_nonempty_btn.setToolTip("Skip to the next slice holding more than background")
+        self.hotspot_btn = QPushButton("Find max")
+        self.hotspot_btn.setToolTip(
+            "Jump to the hottest voxel of the ROI, the zoomed region or the volume; "
+            "press again for the next peak"
+        )
+        self.peaks_input = QSpinBox()
+        self.peaks_input.setRange(1, 100)
+        self.peaks_input.setValue(HOTSPOT_PEAKS)
+        self.peaks_input.setPrefix("Top ")
+        self.peak_radius_input = QSpinBox()
+        self.peak_radius_input.setRange(0, 100)
+        self.peak_radius_input.setValue(HOTSPOT_RADIUS)
+        self.peak_radius_input.setPrefix("Local max ± ")
+        self.peak_radius_input.setSuffix(" vx")
+        self.peak_radius_input.setSpecialValueText("Any voxel")
+        self.peak_radius_input.setToolTip(
+            "Only report voxels that are the maximum within this many voxels, so "
+            "each lesion gives one peak; 0 reports the hottest voxels"
+        )
+        self.peak_label = QLabel()
 
         # Layout organization
         control_layout.addWidget(self.zoom_btn)
         control_layout.addWidget(self.drag_btn)
         control_layout.addWidget(self.reset_btn)
+        control_layout.addWidget(self.roi_btn)
+        control_layout.addWidget(self.line_btn)
         control_layout.addWidget(QLabel("Min:"))
         control_layout.addWidget(self.min_input)
         control_layout.addWidget(QLabel("Max:"))
@@ -93,37 +356,149 @@ class VolumeViewer(QMainWindow):
         control_layout.addWidget(self.xy_radio)
         control_layout.addWidget(self.xz_radio)
         control_layout.addWidget(self.yz_radio)
+        control_layout.addWidget(self.interp_combo)
+        control_layout.addWidget(self.colormap_combo)
+        control_layout.addWidget(self.slice_play_btn)
+        control_layout.addWidget(self.slice_fps_input)
+        control_layout.addWidget(self.auto_window_btn)
+        control_layout.addWidget(self.next_nonempty_btn)
+        control_layout.addWidget(self.hotspot_btn)
+        control_layout.addWidget(self.peaks_input)
+        control_layout.addWidget(self.peak_radius_input)
+        control_layout.addWidget(self.peak_label)
 
         # Image display area
         display_layout = QHBoxLayout()
         self.scrollbar = QScrollBar(Qt.Vertical)
-        self.image_label = QLabel()
+        self.slice_profile = SliceProfile()
+        self.image_label = ImageCanvas()
         self.image_label.setSizePolicy(QSizePolicy.Expanding, QSizePolicy.Expanding)
         self.image_label.setAlignment(Qt.AlignCenter)
         self.image_label.setMinimumSize(400, 400)
+        # Hover readout needs move events without a pressed button
+        self.image_label.setMouseTracking(True)
+        central_widget.setMouseTracking(True)
+        self.setMouseTracking(True)
 
         display_layout.addWidget(self.scrollbar)
+        display_layout.addWidget(self.slice_profile)
         display_layout.addWidget(self.image_label)
 
         # Connect signals
         self.reset_btn.clicked.connect(self.reset_view)
-        self.zoom_btn.clicked.connect(lambda: self.drag_btn.setChecked(False))
-        self.drag_btn.clicked.connect(lambda: self.zoom_btn.setChecked(False))
+        for btn in self.tool_btns:
+            btn.clicked.connect(lambda _, btn=btn: self._select_tool(btn))
+        self.roi_btn.toggled.connect(lambda checked: self.roi_bar.setVisible(checked))
         self.min_input.editingFinished.connect(self.update_window_level)
         self.max_input.editingFinished.connect(self.update_window_level)
         self.xy_radio.toggled.connect(lambda: self.set_orientation(0, False))
         self.xz_radio.toggled.connect(lambda: self.set_orientation(1, False))
         self.yz_radio.toggled.connect(lambda: self.set_orientation(2, False))
         self.scrollbar.valueChanged.connect(self.set_slice)
+        self.interp_combo.currentTextChanged.connect(
+            lambda text: self.set_interpolation(text.lower())
+        )
+        self.colormap_combo.currentTextChanged.connect(
+            lambda text: self.set_colormap(text.lower())
+        )
+        self.slice_play_btn.toggled.connect(self.set_slice_playing)
+        self.slice_fps_input.valueChanged.connect(self.slice_cine.set_fps)
+        self.auto_window_btn.toggled.connect(self.set_auto_window)
+        self.next_nonempty_btn.clicked.connect(self.next_nonempty_slice)
+        self.hotspot_btn.clicked.connect(self.find_hotspot)
+        self.slice_profile.slice_clicked.connect(self.scrollbar.setValue)
+
+        # Fusion toolbar, only shown once an overlay is set
+        self.fusion_bar = QWidget()
+        fusion_layout = QHBoxLayout(self.fusion_bar)
+        fusion_layout.setContentsMargins(0, 0, 0, 0)
+        self.overlay_min_input = QLineEdit()
+        self.overlay_max_input = QLineEdit()
+        self.overlay_colormap_combo = QComboBox()
+        self.overlay_colormap_combo.addItems([name.capitalize() for name in COLORMAPS])
+        self.overlay_colormap_combo.setCurrentText(self.overlay_colormap.capitalize())
+        self.alpha_slider = QSlider(Qt.Horizontal)
+        self.alpha_slider.setRange(0, 100)
+        self.alpha_slider.setValue(int(self.overlay_alpha * 100))
+        fusion_layout.addWidget(QLabel("Overlay min:"))
+        fusion_layout.addWidget(self.overlay_min_input)
+        fusion_layout.addWidget(QLabel("Max:"))
+        fusion_layout.addWidget(self.overlay_max_input)
+        fusion_layout.addWidget(self.overlay_colormap_combo)
+        fusion_layout.addWidget(QLabel("Blend:"))
+        fusion_layout.addWidget(self.alpha_slider)
+        self.fusion_bar.hide()
+
+        self.overlay_min_input.editingFinished.connect(self.update_overlay_window_level)
+        self.overlay_max_input.editingFinished.connect(self.update_overlay_window_level)
+        self.overlay_colormap_combo.currentTextChanged.connect(
+            lambda text: self.set_overlay_colormap(text.lower())
+        )
+        self.alpha_slider.valueChanged.connect(lambda v: self.set_overlay_alpha(v / 100))
+
+        # ROI toolbar, shown in ROI mode
+        self.roi_bar = QWidget()
+        roi_layout = QHBoxLayout(self.roi_bar)
+        roi_layout.setContentsMargins(0, 0, 0, 0)
+        self.roi_depth_input = QSpinBox()
+        self.roi_depth_input.setRange(0, max(self.nx, self.ny, self.nz))
+        self.roi_depth_input.setPrefix("± ")
+        self.roi_depth_input.setSuffix(" slices")
+        self.roi_stats_label = QLabel("Draw a rectangle on the slice")
+        self.roi_stats_label.setTextInteractionFlags(Qt.TextSelectableByMouse)
+        self.roi_clear_btn = QPushButton("Clear")
+        roi_layout.addWidget(QLabel("ROI depth:"))
+        roi_layout.addWidget(self.roi_depth_input)
+        roi_layout.addWidget(self.roi_stats_label, 1)
+        roi_layout.addWidget(self.roi_clear_btn)
+        self.roi_bar.hide()
+
+        self.roi_depth_input.valueChanged.connect(self.update_roi_stats)
+        self.roi_clear_btn.clicked.connect(lambda: self.set_roi(None))
+
+        # Time toolbar, only shown for time series
+        self.time_bar = QWidget()
+        time_layout = QHBoxLayout(self.time_bar)
+        time_layout.setContentsMargins(0, 0, 0, 0)
+        self.time_scrollbar = QScrollBar(Qt.Horizontal)
+        self.time_scrollbar.setMaximum(self.nt - 1)
+        self.time_label = QLabel(f"1/{self.nt}")
+        self.play_btn = QPushButton("Play", checkable=True)
+        self.fps_input = QDoubleSpinBox()
+        self.fps_input.setRange(0.5, 120)
+        self.fps_input.setValue(self.cine.fps)
+        self.fps_input.setSuffix(" fps")
+        self.cine_stats_label = QLabel()
+        time_layout.addWidget(QLabel("Frame:"))
+        time_layout.addWidget(self.time_scrollbar)
+        time_layout.addWidget(self.time_label)
+        time_layout.addWidget(self.play_btn)
+        time_layout.addWidget(self.fps_input)
+        time_layout.addWidget(self.cine_stats_label)
+        self.time_bar.setVisible(self.nt > 1)
+
+        self.time_scrollbar.valueChanged.connect(self.set_frame)
+        self.play_btn.toggled.connect(self.set_playing)
+        self.fps_input.valueChanged.connect(self.cine.set_fps)
 
         # Final layout
         main_layout.addLayout(control_layout)
+        main_layout.addWidget(self.fusion_bar)
         main_layout.addLayout(display_layout)
+        main_layout.addWidget(self.roi_bar)
+        main_layout.addWidget(self.time_bar)
 
         self.resize(800, 600)
         self.setWindowTitle("Volume Viewer")
         self.show()
         self.reset_view()
+        self.set_stats(self.stats)
+
+    def _select_tool(self, selected):
+        """Mouse tools are exclusive, checking one unchecks the others"""
+        for btn in self.tool_btns:
+            if btn is not selected:
+                btn.setChecked(False)
 
     def reset_view(self, internal=False):
         slice_data = self.get_current_slice()
@@ -132,63 +507,395 @@ class VolumeViewer(QMainWindow):
         self.set_view_rect(new_view_rect, internal=internal)
 
     def get_current_slice(self):
-        if self.orientation == 0:  # XY
-            return self.volume[self.current_slice]
-        elif self.orientation == 1:  # XZ
-            return self.volume[:, self.current_slice]
-        return self.volume[:, :, self.current_slice]  # YZ
+        return self.slice_cache.get(
+            self.orientation, self.current_slice, self.current_frame
+        )
+
+    def set_interpolation(self, method):
+        self.interpolation = method
+        self.update_display()
+
+    def set_colormap(self, name):
+        """Switch colormap by swapping the colour table of the cached indices"""
+        self.colormap = name
+        self.color_table = colormap_lut(name).tolist()
+        if self._indices is not None:
+            self._show_indices()
+
+    def set_fusion_overlay(self, volume, geometry=None, window_level=None):
+        """Fuse a second volume on top of this one (None removes it)
+
+        The overlay is resampled onto the displayed frame through the base to
+        overlay index transform, so it may live on a different grid.
+        """
+        self.overlay = volume
+        self._overlay_indices_key = None
+        if volume is None:
+            self.fusion_bar.hide()
+            self.update_display()
+            return
+
+        self.overlay_geometry = geometry or ImageGeometry()
+        self.overlay_transform = index_transform(self.geometry, self.overlay_geometry)
+        if window_level is None:
+            window_level = volume_range(volume)
+        self.overlay_window_level = list(window_level)
+        self.overlay_min_input.setText(str(window_level[0]))
+        self.overlay_max_input.setText(str(window_level[1]))
+        self.fusion_bar.show()
+        self.update_display()
+
+    def update_overlay_window_level(self):
+        try:
+            self.overlay_window_level = [
+                float(self.overlay_min_input.text()),
+                float(self.overlay_max_input.text()),
+            ]
+        except ValueError:
+            return
+        self.update_display()
+
+    def set_overlay_colormap(self, name):
+        self.overlay_colormap = name
+        if self._overlay_indices is not None:
+            self._show_indices()
+
+    def set_overlay_alpha(self, alpha):
+        """Only re-blends the cached index frames"""
+        self.overlay_alpha = alpha
+        if self._overlay_indices is not None:
+            self._show_indices()
+
+    def _render_method(self):
+        if self.interpolation != "adaptive":
+            return self.interpolation
+        if self._render_high_quality:
+            return self.ADAPTIVE_QUALITY
+        # Restarted on every render, so it only fires once interaction stops
+        self.idle_timer.start()
+        return "nearest"
+
+    def _render_idle(self):
+        self._render_high_quality = True
+        try:
+            self.update_display()
+        finally:
+            self._render_high_quality = False
+
+    def set_render_worker(self, worker):
+        """Render frames in a worker process (render_worker.RenderWorker)"""
+        self.render_worker = worker
+        worker.setParent(self)
+        worker.frame_ready.connect(self._worker_frame_ready)
+
+    def _worker_frame_ready(self, indices_key, indices, rect):
+        if indices_key != self._requested_key:
+            # Stale (asked before a refresh), the current request is on its way.
+            # The worker writes the next frame over the slot still shown, keep a copy.
+            if self._indices is not None:
+                self._indices = self._indices.copy()
+            return
+        self._indices_key, self._indices, self._indices_rect = indices_key, indices, rect
+        self._present(indices_key[0])
+
+    def refresh_data(self):
+        """Re-render after voxels changed in place, keeping window, view and slice"""
+        self._frame_key = self._indices_key = self._requested_key = None
+        self._overlay_indices_key = None
+        self.peaks = None
+        self.update_display()
+        if self.profile_line is not None:
+            self._sample_profile()
+        self.update_roi_stats()
 
     def update_display(self):
-        # Get image data
-        slice_data = self.get_current_slice()
-        h, w = slice_data.shape
+        h, w = slice_shape(self.volume, self.orientation)
 
         # Initialize view rectangle
         if self.view_rect is None:
             self.view_rect = (0, w, 0, h)
 
         x_min, x_max, y_min, y_max = self.view_rect
-        x_min = int(x_min)
-        x_max = int(x_max)
-        y_min = int(y_min)
-        y_max = int(y_max)
         view_w = x_max - x_min
         view_h = y_max - y_min
 
-        # Apply window level to the visible region
-        visible_data = slice_data[int(y_min) : int(y_max), int(x_min) : int(x_max)]
-        data = np.clip(
-            (visible_data - self.window_level[0])
-            / (self.window_level[1] - self.window_level[0]),
-            0,
-            1,
+        # Largest frame with the physical aspect of the view that fits the
+        # canvas, in device pixels
+        canvas_size = self.image_label.size()
+        dpr = self.image_label.devicePixelRatioF()
+        out_w, out_h = fit_to_canvas(
+            view_w,
+            view_h,
+            self.geometry.plane_spacing(self.orientation),
+            canvas_size.width() * dpr,
+            canvas_size.height() * dpr,
         )
-        data = (data * 255).astype(np.uint8)
-
-        # Create pixmap
-        qimage = QImage(data.data, view_w, view_h, view_w, QImage.Format_Grayscale8)
-        pixmap = QPixmap.fromImage(qimage)
 
-        # Scale to exactly fill the canvas
-        canvas_size = self.image_label.size()
-        scaled_pix = pixmap.scaled(
-            canvas_size, Qt.IgnoreAspectRatio, Qt.FastTransformation
+        # Resample only the frame pixels, unless they are cached
+        method = self._render_method()
+        frame_key = (
+            self.current_frame,
+            self.orientation,
+            self.current_slice,
+            tuple(self.view_rect),
+            out_w,
+            out_h,
+            method,
+        )
+        indices_key = (frame_key, tuple(self.window_level))
+        slice_key = (self.current_frame, self.orientation, self.current_slice)
+        if indices_key != self._indices_key:
+            if frame_key == self._frame_key:
+                # Same frame (e.g. rendered ahead by cine), only re-window it
+                self._indices = window_to_uint8(self._frame, *self.window_level)
+                self._indices_rect = self.view_rect
+            elif self.render_worker is not None:
+                # Shown by _worker_frame_ready once the worker is done
+                if indices_key != self._requested_key:
+                    self._requested_key = indices_key
+                    self.render_worker.request(
+                        indices_key, slice_key, self.view_rect, out_w, out_h, self.window_level, method
+                    )
+                return
+            else:
+                # Windowed screen tiles, panning only renders the exposed ones
+                self._indices, self._indices_rect = self.tile_cache.render(
+                    self.get_current_slice(),
+                    slice_key,
+                    self.view_rect,
+                    out_w,
+                    out_h,
+                    self.window_level,
+                    method,
+                )
+            self._indices_key = indices_key
+        self._present(frame_key)
+
+    def _present(self, frame_key):
+        if self.overlay is not None:
+            self._update_overlay_indices(frame_key)
+        self._show_indices()
+
+    def _update_overlay_indices(self, frame_key):
+        """Resample the overlay onto the current frame and window it"""
+        overlay_key = (frame_key, tuple(self.overlay_window_level))
+        if overlay_key == self._overlay_indices_key:
+            return
+        time_frame, orientation, slice_index, _, out_w, out_h, method = frame_key
+        view_rect = self._indices_rect  # Aligned with the rendered base frame
+        points = plane_sample_points(
+            self.overlay_transform, orientation, slice_index, view_rect, out_w, out_h
+        )
+        frame = sample_volume(
+            frame_volume(self.overlay, time_frame),
+            points,
+            "nearest" if method == "nearest" else "linear",
         )
+        self._overlay_valid = np.isfinite(frame)
+        frame[~self._overlay_valid] = self.overlay_window_level[0]
+        self._overlay_indices = window_to_uint8(frame, *self.overlay_window_level)
+        self._overlay_indices_key = overlay_key
+
+    def _show_indices(self):
+        """Display the cached indices through the current colour table"""
+        out_h, out_w = self._indices.shape
+        if self.overlay is not None and self._overlay_indices is not None:
+            argb = fuse_indices(
+                self._indices,
+                self._overlay_indices,
+                self._overlay_valid,
+                self.colormap,
+                self.overlay_colormap,
+                self.overlay_alpha,
+            )
+            qimage = QImage(argb.data, out_w, out_h, out_w * 4, QImage.Format_ARGB32)
+        else:
+            qimage = QImage(
+                self._indices.data, out_w, out_h, out_w, QImage.Format_Indexed8
+            )
+            qimage.setColorTable(self.color_table)
+        # Pixmap is already at its display size (centered by the label)
+        self._pixmap = QPixmap.fromImage(qimage)
+        self._pixmap.setDevicePixelRatio(self.image_label.devicePixelRatioF())
+        self._set_pixmap(self._pixmap)
 
-        self.image_label.setPixmap(scaled_pix)
+    def _set_pixmap(self, pixmap):
+        """Show a pixmap of the rendered view and store its mapping information"""
+        self.image_label.setPixmap(pixmap)
 
-        # Store mapping information
+        # Pixmap rect in window coordinates, and the view rect it shows
+        canvas_size = self.image_label.size()
+        display_w = pixmap.width() / pixmap.devicePixelRatioF()
+        display_h = pixmap.height() / pixmap.devicePixelRatioF()
+        label_origin = self.image_label.mapTo(self, QPoint(0, 0))
         self.last_pixmap_info = (
             QRectF(
-                self.image_label.x(),
-                self.image_label.y(),
-                canvas_size.width(),
-                canvas_size.height(),
+                label_origin.x() + (canvas_size.width() - display_w) / 2,
+                label_origin.y() + (canvas_size.height() - display_h) / 2,
+                display_w,
+                display_h,
+            ),
+            QRectF(
+                self._indices_rect[0],
+                self._indices_rect[2],
+                self._indices_rect[1] - self._indices_rect[0],
+                self._indices_rect[3] - self._indices_rect[2],
             ),
-            QRectF(x_min, y_min, view_w, view_h),
         )
+        if self.hover_point is not None:
+            # Follow the new view, slice, frame or size
+            self.set_hover(self.hover_point, internal=True)
+
+    def resizeEvent(self, event):
+        """Stretch the current frame to the new canvas, re-render once settled"""
+        super().resizeEvent(event)
+        if self._pixmap is None:
+            return
+        dpr = self.image_label.devicePixelRatioF()
+        canvas_size = self.image_label.size() * dpr
+        stretched = self._pixmap.scaled(
+            canvas_size, Qt.KeepAspectRatio, Qt.FastTransformation
+        )
+        stretched.setDevicePixelRatio(dpr)
+        self._set_pixmap(stretched)
+        self.resize_timer.start()
 
-    def set_slice(self, value, internal=False):
+    def set_frame(self, frame, internal=False):
+        """Show another time frame of a time series"""
+        frame = int(clamp(frame, 0, self.nt - 1))
+        if not internal:
+            self.frame_changed.emit(frame)
+        self.time_scrollbar.blockSignals(True)
+        self.time_scrollbar.setValue(frame)
+        self.time_scrollbar.blockSignals(False)
+        self.time_label.setText(f"{frame + 1}/{self.nt}")
+        self.current_frame = frame
+        self._update_slice_profile()
+        self._apply_auto_window()
+        self.update_display()
+        self.update_roi_stats()
+        if self.profile_line is not None:
+            self._sample_profile()
+
+    def set_playing(self, playing):
+        if playing and self.nt > 1:
+            self.cine.start(self.current_frame)
+        else:
+            self.cine.stop()
+        self.play_btn.blockSignals(True)
+        self.play_btn.setChecked(self.cine.is_playing())
+        self.play_btn.blockSignals(False)
+
+    def set_slice_playing(self, playing, follow=False):
+        """Sweep current_slice at the cine rate
+
+        With follow=True the player has no timer of its own and only renders
+        ahead, while another viewer's playback drives set_slice through sync.
+        """
+        if playing:
+            self.slice_cine.start(self.current_slice, paced=not follow)
+        else:
+            self.slice_cine.stop()
+            self.statusBar().clearMessage()
+        self.slice_play_btn.blockSignals(True)
+        self.slice_play_btn.setChecked(self.slice_cine.is_playing())
+        self.slice_play_btn.blockSignals(False)
+        if not follow:
+            self.slice_playback_toggled.emit(self.slice_cine.is_playing())
+
+    def _playback_key(self, frame=None, slice_index=None):
+        """Frame key update_display would use for a frame during playback"""
+        if self._indices_key is None:
+            return None
+        method = "nearest" if self.interpolation == "adaptive" else self.interpolation
+        key = list(self._indices_key[0])
+        if frame is not None:
+            key[0] = frame
+        if slice_index is not None:
+            key[2] = slice_index
+        key[-1] = method
+        return tuple(key)
+
+    def _make_job(self, frame_key):
+        """Snapshot the render state on the GUI thread for a worker to render
+
+        With auto window the frame is windowed as its own slice will be, from
+        the slice statistics, so frames rendered ahead stay valid.
+        """
+        window_level = tuple(self.window_level)
+        if self.auto_window and self.stats and frame_key[0] in self.stats:
+            slice_window = self.stats[frame_key[0]].slice_window(frame_key[1], frame_key[2])
+            if slice_window is not None:
+                window_level = tuple(slice_window)
+        volume = self.volume
+
+        def job():
+            frame, orientation, slice_index, view_rect, out_w, out_h, method = frame_key
+            slice_data = extract_slice(volume, orientation, slice_index, frame)
+            data = resample_slice(slice_data, view_rect, out_w, out_h, method)
+            indices = window_to_uint8(data, *window_level)
+            return frame_key, data, (frame_key, window_level), indices
+
+        return job
+
+    def _cine_job(self, frame):
+        return self._make_job(self._playback_key(frame=frame))
+
+    def _slice_cine_job(self, slice_index):
+        return self._make_job(self._playback_key(slice_index=slice_index))
+
+    def _install_cine_frame(self, result, player):
+        """Adopt a frame rendered ahead if it still matches the current view"""
+        frame_key, data, indices_key, indices = result
+        expected = self._playback_key(self.current_frame, self.current_slice)
+        if frame_key != expected or (
+            indices_key[1] != tuple(self.window_level) and not self.auto_window
+        ):
+            # View changed since the frame was queued, re-render the buffer
+            player.flush()
+            return
+        # With auto window, update_display re-windows the data if the window differs
+        self._frame_key, self._frame = frame_key, data
+        self._indices_key, self._indices = indices_key, indices
+
+    def _show_cine_frame(self, frame, result):
+        self.current_frame = frame
+        self._install_cine_frame(result, self.cine)
+        self.set_frame(frame)
+
+    def _show_slice_cine_frame(self, slice_index, result):
+        self.current_slice = slice_index
+        self._install_cine_frame(result, self.slice_cine)
+        self.set_slice(slice_index, internal=True)
+        self.slice_changed.emit(slice_index)
+
+    def _show_cine_stats(self, fps, dropped):
+        self.cine_stats_label.setText(f"{fps:.1f} fps, {dropped} dropped")
+
+    def _show_slice_cine_stats(self, fps, dropped):
+        if self.slice_cine.following:
+            message = f"Cine (synced): {fps:.1f} fps, {dropped} rendered late"
+        else:
+            message = f"Cine: {fps:.1f} fps (target {self.slice_cine.fps:g}), {dropped} dropped"
+        self.statusBar().showMessage(message)
+
+    def _cine_failed(self, message):
+        self.set_playing(False)
+        self.statusBar().showMessage(f"Cine stopped: {message}")
+
+    def _slice_cine_failed(self, message):
+        self.set_slice_playing(False)
+        self.statusBar().showMessage(f"Cine stopped: {message}")
+
+    def closeEvent(self, event):
+        self.cine.shutdown()
+        self.slice_cine.shutdown()
+        if self.render_worker is not None:
+            self.render_worker.close()
+        super().closeEvent(event)
+        self.closed.emit()
+
+    def set_slice(self, value, internal=False, render=True):
         if not internal:
             self.slice_changed.emit(value)
         else:
@@ -197,7 +904,23 @@ class VolumeViewer(QMainWindow):
             self.scrollbar.blockSignals(False)
 
         self.current_slice = value
-        self.update_display()
+        self.slice_profile.set_current(value)
+        self._apply_auto_window()
+        if self.profile_line is not None:
+            # Lines drawn in the slice plane move along with it
+            _, _, slice_axis = PLANE_AXES[self.orientation]
+            start, end = (np.array(p, dtype=float) for p in self.profile_line)
+            if np.isclose(start[slice_axis], end[slice_axis]):
+                start[slice_axis] = end[slice_axis] = value
+                self.set_profile_line((start, end), internal=True)
+        if self.slice_cine.following:
+            # Driven by a synced viewer's playback, use the frame rendered ahead
+            result = self.slice_cine.take(value)
+            if result is not None:
+                self._install_cine_frame(result, self.slice_cine)
+        if render:
+            self.update_display()
+            self.update_roi_stats()
 
     def set_orientation(self, orientation, internal=False):
         """Updated set_orientation method"""
@@ -220,10 +943,17 @@ class VolumeViewer(QMainWindow):
             self.yz_radio.blockSignals(False)
 
         max_slice = {0: self.nz - 1, 1: self.ny - 1, 2: self.nx - 1}[orientation]
+        if self.slice_cine.is_playing():
+            self.set_slice_playing(False)
+        self.slice_cine.set_num_frames(max_slice + 1)
         self.scrollbar.setMaximum(max_slice)
         self.current_slice = min(self.current_slice, max_slice)
         self.scrollbar.setValue(self.current_slice)
+        self._update_slice_profile()
+        self._apply_auto_window()
         self.view_rect = None
+        self.set_roi(None)
+        self.set_profile_line(None, internal=True)
         self.update_display()
 
     def set_view_rect(self, view_rect, internal=False):
@@ -234,18 +964,152 @@ class VolumeViewer(QMainWindow):
 
     def update_window_level(self):
         try:
-            self.set_window_level(
-                float(self.min_input.text()), float(self.max_input.text())
-            )
+            window_level = [float(self.min_input.text()), float(self.max_input.text())]
         except ValueError:
-            pass
+            return
+        if self.auto_window:  # Typing a window takes over from the slice statistics
+            self._manual_window = window_level
+            self.auto_window_btn.setChecked(False)
+        self.set_window_level(*window_level)
 
-    def set_window_level(self, min_val, max_val, internal=False):
+    def set_window_level(self, min_val, max_val, internal=False, render=True):
         if not internal:
             self.intensity_changed.emit((min_val, max_val))
+        else:
+            self.min_input.setText(str(min_val))
+            self.max_input.setText(str(max_val))
         self.window_level = [min_val, max_val]
+        if render:
+            self.update_display()
+
+    def set_stats(self, stats):
+        """Use per-slice statistics ({frame: stats.VolumeStats}, None while computing)"""
+        self.stats = stats
+        self._update_slice_profile()
+        if self.auto_window:
+            self._apply_auto_window()
+            self.update_display()
+
+    def _frame_stats(self):
+        """Statistics of the displayed frame, None if not computed"""
+        return self.stats.get(self.current_frame) if self.stats else None
+
+    def _update_slice_profile(self):
+        """Show the statistics of the displayed frame, the controls need them"""
+        enabled = self._frame_stats() is not None
+        self.auto_window_btn.setEnabled(enabled)
+        self.next_nonempty_btn.setEnabled(enabled)
+        self.slice_profile.set_profile(self._frame_stats(), self.orientation)
+        self.slice_profile.set_current(self.current_slice)
+
+    def set_auto_window(self, enabled):
+        """Window every slice to its own percentiles, without rescanning it"""
+        if enabled == self.auto_window:
+            return
+        self.auto_window = enabled
+        if enabled:
+            self._manual_window = list(self.window_level)
+            self._apply_auto_window()
+        elif self._manual_window is not None:
+            self.min_input.setText(str(self._manual_window[0]))
+            self.max_input.setText(str(self._manual_window[1]))
+            self.window_level = self._manual_window
         self.update_display()
 
+    def _apply_auto_window(self):
+        """Set the window of the current slice, the caller re-renders"""
+        stats = self._frame_stats()
+        if not self.auto_window or stats is None:
+            return
+        window = stats.slice_window(self.orientation, self.current_slice)
+        if window is None:
+            return
+        self.window_level = window
+        self.min_input.setText(f"{window[0]:.6g}")
+        self.max_input.setText(f"{window[1]:.6g}")
+
+    def _search_box(self):
+        """ZYX box of the hotspot search: the ROI, else the zoomed region, else None (all)"""
+        n = num_slices(self.volume, self.orientation)
+        if self.roi_rect is not None:
+            depth = self.roi_depth_input.value()
+            slices = (max(0, self.current_slice - depth), min(n, self.current_slice + depth + 1))
+            return plane_box(self.orientation, self.roi_rect, slices)
+        h, w = slice_shape(self.volume, self.orientation)
+        if self.view_rect is not None:
+            x_min, x_max, y_min, y_max = self.view_rect
+            rect = (max(0, x_min), min(w, np.ceil(x_max)), max(0, y_min), min(h, np.ceil(y_max)))
+            if rect != (0, w, 0, h):
+                return plane_box(self.orientation, rect, (0, n))
+        return None
+
+    def find_hotspot(self):
+        """Jump to the hottest voxel of the search box, then to the next peaks
+
+        Peaks are local maxima within the radius set next to the button, see
+        hotspot.find_peaks. The search runs again once the view was moved
+        away from the last peak shown, or the frame, the number of peaks or
+        the radius changed.
+        """
+        if self.peaks and self._peaks_key == self._hotspot_key():
+            self.peak_index = (self.peak_index + 1) % len(self.peaks)
+        else:
+            QApplication.setOverrideCursor(Qt.WaitCursor)
+            try:
+                self.peaks = find_peaks(
+                    self.volume,
+                    self.peaks_input.value(),
+                    self.peak_radius_input.value(),
+                    self._search_box(),
+                    self.current_frame,
+                    self._frame_stats(),
+                )
+            finally:
+                QApplication.restoreOverrideCursor()
+            self.peak_index = 0
+        if not self.peaks:
+            self.peak_label.setText("No peak")
+            return
+        value, point = self.peaks[self.peak_index]
+        self.peak_label.setText(f"{self.peak_index + 1}/{len(self.peaks)}: {value:.6g}")
+        self.go_to_point(point)
+        self._peaks_key = self._hotspot_key()
+
+    def _hotspot_key(self):
+        return (
+            self.current_frame,
+            self.peaks_input.value(),
+            self.peak_radius_input.value(),
+            self.orientation,
+            self.current_slice,
+            self.view_rect,
+            self.roi_rect,
+        )
+
+    def go_to_point(self, point):
+        """Show an XYZ voxel: its slice, the view centered on it, and its readout
+
+        Goes through the synced signals, so every synced viewer follows.
+        """
+        column_axis, row_axis, slice_axis = PLANE_AXES[self.orientation]
+        self.scrollbar.setValue(int(point[slice_axis]))
+        h, w = slice_shape(self.volume, self.orientation)
+        x_min, x_max, y_min, y_max = self.view_rect or (0, w, 0, h)
+        half_w, half_h = (x_max - x_min) / 2, (y_max - y_min) / 2
+        column, row = point[column_axis] + 0.5, point[row_axis] + 0.5
+        if (x_max - x_min, y_max - y_min) != (w, h):  # Zoomed, follow the peak
+            self.set_view_rect((column - half_w, column + half_w, row - half_h, row + half_h))
+        self.set_hover(np.asarray(point, dtype=float))
+
+    def next_nonempty_slice(self):
+        """Move to the next slice that is not background only, wrapping around"""
+        stats = self._frame_stats()
+        if stats is None:
+            return
+        index = stats.next_nonempty(self.orientation, self.current_slice)
+        if index is not None and index != self.current_slice:
+            self.scrollbar.setValue(index)
+
     def mousePressEvent(self, event: QMouseEvent):
         if self.image_label.underMouse():
             # Store initial view rectangle and precise start position
@@ -253,8 +1117,31 @@ class VolumeViewer(QMainWindow):
             self.drag_start_pos = self.mapToImage(event.pos())
             self.drag_start_pos_map = event.pos()
             self.dragging = True
+            # Pressing inside the ROI grabs it, anywhere else draws a new one
+            self.roi_drag_start = None
+            if self.roi_btn.isChecked() and self.roi_rect is not None:
+                x_min, x_max, y_min, y_max = self.roi_rect
+                x, y = self.drag_start_pos.x(), self.drag_start_pos.y()
+                if x_min <= x < x_max and y_min <= y < y_max:
+                    self.roi_drag_start = self.roi_rect
+            # Pressing on a line endpoint drags it, anywhere else starts a line
+            self.profile_grab = None
+            if self.line_btn.isChecked():
+                label_pos = QPointF(self.image_label.mapFrom(self, event.pos()))
+                for i, end in enumerate(self.profile_line or ()):
+                    if (self._label_position(end) - label_pos).manhattanLength() < 8:
+                        self.profile_grab = i
+                if self.profile_grab is None:
+                    point = self._event_point(event)
+                    self.profile_line = (point, point)
+                    self.profile_grab = 1
 
     def mouseMoveEvent(self, event: QMouseEvent):
+        if self.image_label.underMouse() and self.last_pixmap_info:
+            self.set_hover(self._event_point(event))
+        elif self.hover_point is not None:
+            self.set_hover(None)
+
         if self.dragging and self.drag_btn.isChecked():
             # Get current position in image coordinates
             current_pos_map = event.pos()
@@ -301,51 +1188,238 @@ class VolumeViewer(QMainWindow):
                     view_rect = (new_x_min, new_x_max, new_y_min, new_y_max)
                     self.set_view_rect(view_rect)
 
-        elif self.zoom_btn.isChecked():
-            # Get current position in image coordinates
+        elif self.dragging and self.roi_btn.isChecked():
             current_pos = self.mapToImage(event.pos())
+            if self.roi_drag_start is not None:
+                # Move the grabbed ROI, kept inside the slice
+                x_min, x_max, y_min, y_max = self.roi_drag_start
+                dx = clamp(
+                    current_pos.x() - self.drag_start_pos.x(),
+                    -x_min,
+                    self.get_current_width() - x_max,
+                )
+                dy = clamp(
+                    current_pos.y() - self.drag_start_pos.y(),
+                    -y_min,
+                    self.get_current_height() - y_max,
+                )
+                self.set_roi((x_min + dx, x_max + dx, y_min + dy, y_max + dy))
+            else:
+                self.set_roi(self._image_rect(self.drag_start_pos, current_pos))
 
-            # Draw zoom rectangle directly on image coordinates
-            self.update_display()
-            painter = QPainter(self.image_label.pixmap())
-            painter.setPen(QColor(255, 0, 0))
+        elif self.dragging and self.profile_grab is not None:
+            line = list(self.profile_line)
+            line[self.profile_grab] = self._event_point(event)
+            self.set_profile_line(tuple(line))
+
+        elif self.dragging and self.zoom_btn.isChecked():
+            # Get current position in image coordinates
+            current_pos = self.mapToImage(event.pos())
 
             # Convert coordinates to widget space
             start = self.mapFromImage(self.drag_start_pos)
             end = self.mapFromImage(current_pos)
             rect = QRectF(start, end).normalized()
 
-            painter.drawRect(rect)
-            painter.end()
-            self.image_label.repaint()
+            # Draw zoom rectangle as an overlay, the slice is not re-rendered
+            def paint_zoom_rect(painter):
+                painter.setPen(QColor(255, 0, 0))
+                painter.drawRect(rect)
+
+            self.image_label.set_overlay("zoom_rect", paint_zoom_rect)
 
     def mouseReleaseEvent(self, event: QMouseEvent):
         if self.dragging and self.zoom_btn.isChecked():
             end_pos = self.mapToImage(event.pos())
+            x_min, x_max, y_min, y_max = self._image_rect(self.drag_start_pos, end_pos)
 
-            x_min = int(min(self.drag_start_pos.x(), end_pos.x()))
-            x_max = int(max(self.drag_start_pos.x(), end_pos.x()))
-            y_min = int(min(self.drag_start_pos.y(), end_pos.y()))
-            y_max = int(max(self.drag_start_pos.y(), end_pos.y()))
-
-            current_width = self.get_current_width()
-            current_height = self.get_current_height()
-
-            x_min = clamp(x_min, 0, current_width)
-            x_max = clamp(x_max, 0, current_width)
-            y_min = clamp(y_min, 0, current_height)
-            y_max = clamp(y_max, 0, current_height)
-
+            self.image_label.set_overlay("zoom_rect", None)
             if x_max - x_min > 2 and y_max - y_min > 2:
                 view_rect = (x_min, x_max, y_min, y_max)
                 self.set_view_rect(view_rect)
 
+        if self.profile_grab is not None:
+            start, end = self.profile_line
+            if np.linalg.norm(end - start) < 1:
+                self.set_profile_line(None)
         self.dragging = False
+        self.roi_drag_start = None
+        self.profile_grab = None
+
+    def _event_point(self, event):
+        """Continuous XYZ index under a mouse event, on the current slice"""
+        pos = self.mapToImage(event.pos(), exact=True)
+        return plane_point(
+            self.orientation, pos.x() - 0.5, pos.y() - 0.5, self.current_slice
+        )
+
+    def _label_position(self, point):
+        """image_label position of the in-plane projection of an XYZ index"""
+        column_axis, row_axis, _ = PLANE_AXES[self.orientation]
+        return self.mapFromImage(QPointF(point[column_axis] + 0.5, point[row_axis] + 0.5))
+
+    def set_profile_line(self, line, internal=False):
+        """Sample an intensity profile along (start, end) XYZ indices, None clears it"""
+        self.profile_line = line
+        if line is None:
+            self.profile = None
+            self.image_label.set_overlay("profile", None)
+            self.profile_updated.emit()
+        else:
+            self._sample_profile()
+            _, _, slice_axis = PLANE_AXES[self.orientation]
+            on_slice = all(
+                abs(p[slice_axis] - self.current_slice) < 0.5 for p in line
+            )
+
+            # Mapped at paint time, so the line follows zoom and pan
+            def paint_profile(painter):
+                start, end = (self._label_position(p) for p in self.profile_line)
+                pen = QPen(QColor(0, 200, 255))
+                if not on_slice:
+                    pen.setStyle(Qt.DashLine)
+                painter.setPen(pen)
+                painter.drawLine(start, end)
+                painter.drawEllipse(start, 3, 3)
+                painter.drawEllipse(end, 3, 3)
+
+            self.image_label.set_overlay("profile", paint_profile)
+        if not internal:
+            self.profile_line_changed.emit(line)
+
+    def _sample_profile(self):
+        """Trilinear samples along profile_line, two per voxel of length"""
+        start, end = (np.asarray(p, dtype=float) for p in self.profile_line)
+        num = max(2, int(np.ceil(np.linalg.norm(end - start) * 2)) + 1)
+        values = sample_line(self.volume, start, end, num, self.current_frame)
+        length = np.linalg.norm(
+            self.geometry.to_physical(end) - self.geometry.to_physical(start)
+        )
+        self.profile = (np.linspace(0, length, num), values)
+        self.profile_updated.emit()
+
+    def _image_rect(self, start_pos, end_pos):
+        """(x_min, x_max, y_min, y_max) spanned by two image positions, inside the slice"""
+        current_width = self.get_current_width()
+        current_height = self.get_current_height()
+        return (
+            clamp(int(min(start_pos.x(), end_pos.x())), 0, current_width),
+            clamp(int(max(start_pos.x(), end_pos.x())), 0, current_width),
+            clamp(int(min(start_pos.y(), end_pos.y())), 0, current_height),
+            clamp(int(max(start_pos.y(), end_pos.y())), 0, current_height),
+        )
+
+    def set_roi(self, rect):
+        """Set the ROI (x_min, x_max, y_min, y_max) in slice coordinates, None clears it"""
+        if rect is not None and (rect[1] <= rect[0] or rect[3] <= rect[2]):
+            rect = None
+        self.roi_rect = rect
+        if rect is None:
+            self.image_label.set_overlay("roi", None)
+        else:
+            # Mapped at paint time, so the ROI follows zoom and pan
+            def paint_roi(painter):
+                x_min, x_max, y_min, y_max = self.roi_rect
+                start = self.mapFromImage(QPointF(x_min, y_min))
+                end = self.mapFromImage(QPointF(x_max, y_max))
+                painter.setPen(QColor(0, 255, 0))
+                painter.drawRect(QRectF(start, end))
+
+            self.image_label.set_overlay("roi", paint_roi)
+        self.update_roi_stats()
+
+    def update_roi_stats(self):
+        """Statistics of the ROI on the current slice, or over ± depth slices"""
+        if self.roi_rect is None:
+            self.roi_stats_label.setText("Draw a rectangle on the slice")
+            return
+        depth = self.roi_depth_input.value()
+        first = max(0, self.current_slice - depth)
+        last = min(num_slices(self.volume, self.orientation), self.current_slice + depth + 1)
+        stats = self.roi_stats.plane(
+            self.orientation, self.roi_rect, (first, last), self.current_frame
+        )
+        text = (
+            f"n={stats.count}  mean={stats.mean:.6g}  std={stats.std:.6g}  "
+            f"min={stats.min:.6g}  max={stats.max:.6g}  sum={stats.total:.6g}"
+        )
+        if last - first > 1:
+            text += f"  (slices {first}-{last - 1})"
+        storage = storage_kind(self.volume)
+        if storage is not None:
+            text += f"  [from {storage} storage]"
+        self.roi_stats_label.setText(text)
+
+    def leaveEvent(self, event):
+        if self.hover_point is not None:
+            self.set_hover(None)
+        super().leaveEvent(event)
+
+    def set_hover(self, point, internal=False):
+        """Show the voxel value at a continuous XYZ index, None hides the readout
+
+        Only the readout is repainted, the slice is not re-rendered. Points
+        off the displayed slice (mirrored from a synced viewer) get a dashed
+        marker at their in-plane position.
+        """
+        if not internal:
+            self.hover_changed.emit(point)
+        self.hover_point = point
+        if point is None or not self.last_pixmap_info:
+            self.image_label.set_overlay("hover", None, self._hover_dirty)
+            self._hover_dirty = None
+            return
+
+        index = [int(round(float(p))) for p in point]
+        if all(0 <= i < n for i, n in zip(index, (self.nx, self.ny, self.nz))):
+            value = voxel_value(self.volume, index, self.current_frame)
+            text = f"({index[0]}, {index[1]}, {index[2]}) {value:.6g}"
+            if not self.geometry.is_default:
+                text += " @ ({:.1f}, {:.1f}, {:.1f})".format(
+                    *self.geometry.to_physical(np.asarray(index, float))
+                )
+        else:
+            text = f"({index[0]}, {index[1]}, {index[2]}) outside"
+
+        _, _, slice_axis = PLANE_AXES[self.orientation]
+        on_slice = abs(point[slice_axis] - self.current_slice) < 0.5
+        center = self._label_position(point)
+        metrics = self.image_label.fontMetrics()
+        text_w = metrics.horizontalAdvance(text) + 8
+        text_h = metrics.height() + 4
+        text_x = center.x() + 10
+        if text_x + text_w > self.image_label.width():
+            text_x = center.x() - 10 - text_w
+        text_y = center.y() + 10
+        if text_y + text_h > self.image_label.height():
+            text_y = center.y() - 10 - text_h
+        text_rect = QRectF(text_x, text_y, text_w, text_h)
+
+        def paint_hover(painter):
+            pen = QPen(QColor(255, 255, 0))
+            if not on_slice:
+                pen.setStyle(Qt.DashLine)
+            painter.setPen(pen)
+            painter.drawLine(center - QPointF(6, 0), center + QPointF(6, 0))
+            painter.drawLine(center - QPointF(0, 6), center + QPointF(0, 6))
+            painter.fillRect(text_rect, QColor(0, 0, 0, 160))
+            painter.drawText(text_rect, Qt.AlignCenter, text)
+
+        dirty = (
+            QRectF(center - QPointF(7, 7), center + QPointF(7, 7))
+            .united(text_rect)
+            .toAlignedRect()
+            .adjusted(-2, -2, 2, 2)
+        )
+        self.image_label.set_overlay(
+            "hover", paint_hover, dirty.united(self._hover_dirty or dirty)
+        )
+        self._hover_dirty = dirty
 
-    def mapToImage(self, pos: QPoint):
-        """Convert widget coordinates to image coordinates (floating-point)"""
+    def mapToImage(self, pos: QPoint, exact=False):
+        """Convert widget coordinates to image coordinates, rounded unless exact"""
         if not self.last_pixmap_info:
-            return QPoint(0, 0)
+            return QPointF(0, 0) if exact else QPoint(0, 0)
 
         widget_rect, image_rect = self.last_pixmap_info
 
@@ -354,35 +1428,331 @@ class VolumeViewer(QMainWindow):
         scale_y = image_rect.height() / widget_rect.height()
 
         # Convert coordinates with floating-point precision
-        img_x = int((pos.x() - widget_rect.x()) * scale_x + self.view_rect[0] + 0.5)
-        img_y = int((pos.y() - widget_rect.y()) * scale_y + self.view_rect[2] + 0.5)
+        img_x = (pos.x() - widget_rect.x()) * scale_x + image_rect.x()
+        img_y = (pos.y() - widget_rect.y()) * scale_y + image_rect.y()
+        if exact:
+            return QPointF(img_x, img_y)
 
-        return QPoint(img_x, img_y)
+        return QPoint(int(img_x + 0.5), int(img_y + 0.5))
 
     def mapFromImage(self, pos: QPoint):
-        """Convert image coordinates to widget coordinates (floating-point)"""
+        """Convert image coordinates to image_label coordinates (floating-point)"""
         if not self.last_pixmap_info:
             return QPointF(0, 0)
 
         widget_rect, image_rect = self.last_pixmap_info
+        label_origin = self.image_label.mapTo(self, QPoint(0, 0))
 
         # Calculate scaling factors
         scale_x = widget_rect.width() / image_rect.width()
         scale_y = widget_rect.height() / image_rect.height()
 
         # Convert coordinates with floating-point precision
-        widget_x = (pos.x() - image_rect.x()) * scale_x
-        widget_y = (pos.y() - image_rect.y()) * scale_y
+        widget_x = (pos.x() - image_rect.x()) * scale_x + widget_rect.x() - label_origin.x()
+        widget_y = (pos.y() - image_rect.y()) * scale_y + widget_rect.y() - label_origin.y()
 
         return QPointF(widget_x, widget_y)
 
     def get_current_width(self):
-        slice_data = self.get_current_slice()
-        return float(slice_data.shape[1])
+        return float(slice_shape(self.volume, self.orientation)[1])
 
     def get_current_height(self):
-        slice_data = self.get_current_slice()
-        return float(slice_data.shape[0])
+        return float(slice_shape(self.volume, self.orientation)[0])
+
+
+class SlicePane(ImageCanvas):
+    """One orthogonal pane of a TriPlanarViewer"""
+
+    clicked = pyqtSignal(int, int)  # (column, row) in slice coordinates
+
+    def __init__(self, orientation, parent=None):
+        super().__init__(parent)
+        self.orientation = orientation
+        self.rendered_slice = None  # Index of the plane currently in the pixmap
+        self.slice_shape = None  # (rows, columns)
+        self.crosshair = None  # (column, row) in slice coordinates
+        self._indices = None  # Windowed indices of the pixmap, recoloured without resampling
+        self.setSizePolicy(QSizePolicy.Expanding, QSizePolicy.Expanding)
+        self.setAlignment(Qt.AlignCenter)
+        self.setMinimumSize(200, 200)
+        self.set_overlay("crosshair", self._paint_crosshair)
+
+    def render(self, slice_index, slice_data, window_level, spacing, color_table):
+        h, w = slice_data.shape
+        dpr = self.devicePixelRatioF()
+        out_w, out_h = fit_to_canvas(
+            w, h, spacing, self.width() * dpr, self.height() * dpr
+        )
+        frame = resample_slice(slice_data, (0, w, 0, h), out_w, out_h)
+        self._indices = window_to_uint8(frame, *window_level)
+        self.set_color_table(color_table)
+        self.slice_shape = (h, w)
+        self.rendered_slice = slice_index
+
+    def set_color_table(self, color_table):
+        """Show the rendered indices through another colour table"""
+        if self._indices is None:
+            return
+        out_h, out_w = self._indices.shape
+        qimage = QImage(self._indices.data, out_w, out_h, out_w, QImage.Format_Indexed8)
+        qimage.setColorTable(color_table)
+        pixmap = QPixmap.fromImage(qimage)
+        pixmap.setDevicePixelRatio(self.devicePixelRatioF())
+        self.setPixmap(pixmap)
+
+    def set_crosshair(self, column, row):
+        if self.crosshair != (column, row):
+            self.crosshair = (column, row)
+            self.update()
+
+    def mapToImage(self, pos):
+        rect = self.pixmap_rect()
+        h, w = self.slice_shape
+        column = int((pos.x() - rect.x()) * w / rect.width())
+        row = int((pos.y() - rect.y()) * h / rect.height())
+        return clamp(column, 0, w - 1), clamp(row, 0, h - 1)
+
+    def mapFromImage(self, column, row):
+        rect = self.pixmap_rect()
+        h, w = self.slice_shape
+        return QPointF(
+            rect.x() + (column + 0.5) * rect.width() / w,
+            rect.y() + (row + 0.5) * rect.height() / h,
+        )
+
+    def _paint_crosshair(self, painter):
+        if self.crosshair is None or self.slice_shape is None:
+            return
+        rect = self.pixmap_rect()
+        center = self.mapFromImage(*self.crosshair)
+        painter.setPen(QPen(QColor(255, 255, 0), 1))
+        painter.drawLine(QPointF(rect.left(), center.y()), QPointF(rect.right(), center.y()))
+        painter.drawLine(QPointF(center.x(), rect.top()), QPointF(center.x(), rect.bottom()))
+
+    def mousePressEvent(self, event: QMouseEvent):
+        if self.slice_shape is not None and event.button() == Qt.LeftButton:
+            self.clicked.emit(*self.mapToImage(event.pos()))
+
+    def mouseMoveEvent(self, event: QMouseEvent):
+        if self.slice_shape is not None and event.buttons() & Qt.LeftButton:
+            self.clicked.emit(*self.mapToImage(event.pos()))
+
+
+class TriPlanarViewer(QMainWindow):
+    """XY, XZ and YZ panes of one volume navigated with a shared crosshair
+
+    The three panes share the volume object and its SliceCache. Moving the
+    crosshair only re-renders the panes whose plane index changed; the
+    others just repaint the crosshair overlay.
+    """
+
+    intensity_changed = pyqtSignal(tuple)
+    crosshair_changed = pyqtSignal(tuple)
+    closed = pyqtSignal()
+
+    def __init__(self, volume_data, slice_cache=None, geometry=None, stats=None, window_level=None):
+        super().__init__()
+        self.volume = volume_data
+        self.stats = stats
+        self.slice_cache = slice_cache or SliceCache(volume_data)
+        self.geometry = geometry or ImageGeometry()
+        volume_shape = self.volume.shape
+        self.nx, self.ny, self.nz = volume_shape[-1], volume_shape[-2], volume_shape[-3]
+        self.crosshair = (self.nx // 2, self.ny // 2, self.nz // 2)  # (x, y, z)
+        self.window_level = window_level or (stats_range(stats) if stats else volume_range(self.volume))
+        self.colormap = "gray"
+        self.color_table = colormap_lut(self.colormap).tolist()
+        self.resize_timer = QTimer(self)
+        self.resize_timer.setSingleShot(True)
+        self.resize_timer.setInterval(VolumeViewer.RESIZE_SETTLE_MS)
+        self.resize_timer.timeout.connect(lambda: self.update_display(force=True))
+        self.initUI()
+
+    def initUI(self):
+        central_widget = QWidget()
+        self.setCentralWidget(central_widget)
+        main_layout = QVBoxLayout(central_widget)
+
+        # Control toolbar
+        control_layout = QHBoxLayout()
+        self.min_input = QLineEdit(str(self.window_level[0]))
+        self.max_input = QLineEdit(str(self.window_level[1]))
+        self.position_label = QLabel()
+        self.colormap_combo = QComboBox()
+        self.colormap_combo.addItems([name.capitalize() for name in COLORMAPS])
+        control_layout.addWidget(QLabel("Min:"))
+        control_layout.addWidget(self.min_input)
+        control_layout.addWidget(QLabel("Max:"))
+        control_layout.addWidget(self.max_input)
+        control_layout.addWidget(self.colormap_combo)
+        control_layout.addWidget(self.position_label)
+
+        # Panes: XY | XZ on top, YZ below
+        panes_layout = QGridLayout()
+        self.panes = [SlicePane(orientation) for orientation in range(3)]
+        panes_layout.addWidget(self.panes[0], 0, 0)
+        panes_layout.addWidget(self.panes[1], 0, 1)
+        panes_layout.addWidget(self.panes[2], 1, 0)
+        for pane in self.panes:
+            pane.clicked.connect(
+                lambda column, row, o=pane.orientation: self._pane_clicked(o, column, row)
+            )
+
+        self.min_input.editingFinished.connect(self.update_window_level)
+        self.max_input.editingFinished.connect(self.update_window_level)
+        self.colormap_combo.currentTextChanged.connect(
+            lambda text: self.set_colormap(text.lower())
+        )
+
+        main_layout.addLayout(control_layout)
+        main_layout.addLayout(panes_layout)
+
+        self.resize(900, 900)
+        self.setWindowTitle("Volume Viewer (tri-planar)")
+        self.show()
+        self.update_display(force=True)
+
+    def _pane_clicked(self, orientation, column, row):
+        column_axis, row_axis, _ = PLANE_AXES[orientation]
+        crosshair = list(self.crosshair)
+        crosshair[column_axis] = column
+        crosshair[row_axis] = row
+        self.set_crosshair(tuple(crosshair))
+
+    def set_crosshair(self, crosshair, internal=False):
+        shape = (self.nx, self.ny, self.nz)
+        crosshair = tuple(int(clamp(c, 0, n - 1)) for c, n in zip(crosshair, shape))
+        if crosshair == self.crosshair:
+            return
+        self.crosshair = crosshair
+        if not internal:
+            self.crosshair_changed.emit(crosshair)
+        self.update_display()
+
+    def update_display(self, force=False):
+        """Re-render panes whose plane changed and move every crosshair"""
+        for pane in self.panes:
+            column_axis, row_axis, slice_axis = PLANE_AXES[pane.orientation]
+            slice_index = self.crosshair[slice_axis]
+            if force or pane.rendered_slice != slice_index:
+                slice_data = self.slice_cache.get(pane.orientation, slice_index)
+                spacing = self.geometry.plane_spacing(pane.orientation)
+                pane.render(
+                    slice_index, slice_data, self.window_level, spacing, self.color_table
+                )
+            pane.set_crosshair(self.crosshair[column_axis], self.crosshair[row_axis])
+
+        x, y, z = self.crosshair
+        value = frame_volume(self.volume)[z, y, x]
+        self.position_label.setText(f"x={x} y={y} z={z} value={value:.6g}")
+
+    def refresh_data(self):
+        """Re-render after voxels changed in place, keeping window and crosshair"""
+        self.update_display(force=True)
+
+    def update_window_level(self):
+        try:
+            self.set_window_level(
+                float(self.min_input.text()), float(self.max_input.text())
+            )
+        except ValueError:
+            pass
+
+    def set_stats(self, stats):
+        self.stats = stats
+
+    def set_window_level(self, min_val, max_val, internal=False, render=True):
+        if not internal:
+            self.intensity_changed.emit((min_val, max_val))
+        else:
+            self.min_input.setText(str(min_val))
+            self.max_input.setText(str(max_val))
+        self.window_level = [min_val, max_val]
+        if render:
+            self.update_display(force=True)
+
+    def set_colormap(self, name):
+        self.colormap = name
+        self.color_table = colormap_lut(name).tolist()
+        for pane in self.panes:
+            pane.set_color_table(self.color_table)
+
+    def resizeEvent(self, event):
+        """Re-render the panes once, after the resize settles"""
+        super().resizeEvent(event)
+        if hasattr(self, "panes"):
+            self.resize_timer.start()
+
+    def closeEvent(self, event):
+        super().closeEvent(event)
+        self.closed.emit()
+
+
+class ProfilePlot(QWidget):
+    """Intensity profiles of the viewers along their profile lines"""
+
+    COLORS = (
+        QColor(0, 200, 255),
+        QColor(255, 160, 0),
+        QColor(0, 220, 0),
+        QColor(255, 60, 60),
+        QColor(200, 100, 255),
+        QColor(255, 255, 0),
+    )
+
+    def __init__(self, parent=None):
+        super().__init__(parent)
+        self.profiles = []  # (label, distances, values)
+        self.unit = "voxels"
+        self.setMinimumSize(400, 250)
+        self.setWindowTitle("Line Profile")
+
+    def set_profiles(self, profiles, unit="voxels"):
+        self.profiles = profiles
+        self.unit = unit
+        self.update()
+
+    def paintEvent(self, event):
+        painter = QPainter(self)
+        painter.fillRect(self.rect(), QColor(20, 20, 20))
+        curves = [c for c in self.profiles if np.isfinite(c[2]).any()]
+        if not curves:
+            painter.setPen(QColor(200, 200, 200))
+            painter.drawText(self.rect(), Qt.AlignCenter, "Draw a line with the Line tool")
+            return
+
+        x_max = max(distances[-1] for _, distances, _ in curves) or 1.0
+        y_min = min(float(np.nanmin(values)) for _, _, values in curves)
+        y_max = max(float(np.nanmax(values)) for _, _, values in curves)
+        if y_max == y_min:
+            y_max = y_min + 1
+
+        plot = QRectF(self.rect()).adjusted(70, 10, -10, -30)
+        painter.setPen(QColor(120, 120, 120))
+        painter.drawRect(plot)
+        painter.drawText(QRectF(0, plot.top(), 65, 20), Qt.AlignRight, f"{y_max:.4g}")
+        painter.drawText(QRectF(0, plot.bottom() - 20, 65, 20), Qt.AlignRight | Qt.AlignBottom, f"{y_min:.4g}")
+        painter.drawText(QRectF(plot.left(), plot.bottom() + 4, plot.width(), 20), Qt.AlignLeft, "0")
+        painter.drawText(
+            QRectF(plot.left(), plot.bottom() + 4, plot.width(), 20),
+            Qt.AlignRight,
+            f"{x_max:.4g} {self.unit}",
+        )
+
+        for n, (label, distances, values) in enumerate(curves):
+            color = self.COLORS[n % len(self.COLORS)]
+            painter.setPen(color)
+            xs = plot.left() + distances / x_max * plot.width()
+            ys = plot.bottom() - (values - y_min) / (y_max - y_min) * plot.height()
+            # Samples outside of the volume (NaN) break the curve
+            finite = np.isfinite(ys)
+            edges = np.flatnonzero(np.diff(np.r_[0, finite.astype(np.int8), 0]))
+            for start, stop in zip(edges[::2], edges[1::2]):
+                painter.drawPolyline(
+                    QPolygonF([QPointF(x, y) for x, y in zip(xs[start:stop], ys[start:stop])])
+                )
+            painter.drawText(QPointF(plot.left() + 8, plot.top() + 16 + 14 * n), label)
+        painter.end()
 
 
 class SyncControl(QDialog):
@@ -395,12 +1765,16 @@ class SyncControl(QDialog):
         self.intensity_sync = QCheckBox("Sync Intensity")
         self.view_sync = QCheckBox("Sync View")
         self.slice_sync = QCheckBox("Sync Slice")
+        self.time_sync = QCheckBox("Sync Time")
+        self.cursor_sync = QCheckBox("Sync Cursor")
 
         # Connect checkboxes to signal
         for cb, name in [
             (self.intensity_sync, "intensity"),
             (self.view_sync, "view"),
             (self.slice_sync, "slice"),
+            (self.time_sync, "time"),
+            (self.cursor_sync, "cursor"),
         ]:
             cb.setChecked(True)
             cb.stateChanged.connect(
@@ -410,48 +1784,518 @@ class SyncControl(QDialog):
         layout.addWidget(self.intensity_sync)
         layout.addWidget(self.view_sync)
         layout.addWidget(self.slice_sync)
+        layout.addWidget(self.time_sync)
+        layout.addWidget(self.cursor_sync)
+
+        self.memory_label = QLabel()
+        layout.addWidget(self.memory_label)
         self.setLayout(layout)
         self.setWindowTitle("Synchronization Controls")
 
 
+class LoadNotifier(QObject):
+    """Relays the completion of loading Futures to the GUI thread"""
+
+    finished = pyqtSignal(int, object)  # (input index, Future)
+    stats_finished = pyqtSignal(object, object)  # (volume, Future)
+
+
 class VolumeViewerManager:
-    def __init__(self, volumes):
-        self.viewers = []
+    def __init__(
+        self,
+        volumes,
+        triplanar=False,
+        geometries=None,
+        overlays=None,
+        comparisons=None,
+        expressions=None,
+        memory_budget=None,
+        render_processes=False,
+        watch=None,
+        streams=None,
+        sources=None,
+    ):
+        # First, the file watcher and timers below need the application
         self.app = QApplication.instance() or QApplication(sys.argv)
+        self.viewers = []
+        self.render_processes = render_processes
+        self.shared_volumes = {}  # id(volume) -> (volume in shared memory, spec)
+        # Inputs filled by a producer, {input index: stream.VolumeStream}
+        self.streams = streams or {}
+        self.stream_windows = {}  # id(volume) -> window level last set from its stream
+        # (filename, format, spacing) of each input, reloaded when rewritten
+        self.watch_specs = watch
+        self.watcher = None
+        if watch:
+            self.watcher = VolumeWatcher()
+            self.watcher.volume_changed.connect(self._volume_changed)
+        self.memory = MemoryGovernor(memory_budget)
+        # (filename, load options) of each input, whose statistics persist in a sidecar
+        self.sources = sources or [None] * len(volumes)
+        self.volume_stats = {}  # id(volume) -> {frame: stats.VolumeStats}
+        self.stats_sources = {}  # id(volume) -> (filename, load options)
+        self.stats_running = {}  # id(volume) -> recompute once done (data changed meanwhile)
+        self.estimated_windows = {}  # id(volume) -> sampled window shown until its stats are ready
+        self.stats_executor = ThreadPoolExecutor(max_workers=1)
+        self.slice_caches = {}  # id(volume) -> SliceCache shared by its views
+        self.roi_stats = {}  # id(volume) -> RoiStats shared by its views
+        self.index_transforms = {}  # (id(source), id(target)) -> 4x4 affine
+        self.profile_plot = None  # Opened with the first profile line
+        geometries = geometries or [None] * len(volumes)
 
         # Create sync control window
         self.sync_control = SyncControl()
         self.sync_control.show()
 
-        # Create viewers
-        for volume in volumes:
-            viewer = VolumeViewer(volume)
-            viewer.show()
-            self._connect_viewer_signals(viewer)
-            self.viewers.append(viewer)
+        # Create viewers. Futures (see loading.load_images) resolving to
+        # (volume, geometry) open their viewer as soon as they complete.
+        self.viewer_class = TriPlanarViewer if triplanar else VolumeViewer
+        self.inputs = [None] * len(volumes)  # Viewer of each input volume
+        self.input_geometries = list(geometries)
+        self.pending = len(volumes)
+        self.derived_specs = (overlays or [], comparisons or [], expressions or [])
+        self.load_notifier = LoadNotifier()
+        self.load_notifier.finished.connect(self._load_finished)
+        self.load_notifier.stats_finished.connect(self._stats_finished)
+        for index, (volume, geometry) in enumerate(zip(volumes, geometries)):
+            if isinstance(volume, Future):
+                volume.add_done_callback(
+                    lambda future, i=index: self.load_notifier.finished.emit(i, future)
+                )
+            else:
+                self._input_ready(index, volume, geometry)
 
         # Connect sync toggles
         self.sync_control.sync_toggled.connect(self.handle_sync_toggled)
 
+        # Caches trim on growth; this also catches viewers going offscreen
+        self.memory_timer = QTimer()
+        self.memory_timer.timeout.connect(self.update_memory)
+        self.memory_timer.start(1000)
+        self.update_memory()
+
+    def _load_finished(self, index, future):
+        try:
+            volume, geometry = future.result()
+        except Exception as e:
+            print(f"Error: could not load image {index}: {e}")
+            volume = None
+        self._input_ready(index, volume, geometry if volume is not None else None)
+
+    def _input_ready(self, index, volume, geometry):
+        if volume is not None:
+            if self.sources[index] is not None:
+                self.load_stats(volume, *self.sources[index])
+            self.inputs[index] = self.add_viewer(volume, geometry)
+            self.input_geometries[index] = geometry
+            if self.watcher is not None and self.watch_specs[index] is not None:
+                self.watcher.watch(self.inputs[index].volume, *self.watch_specs[index])
+            if index in self.streams:
+                volume = self.inputs[index].volume
+                self.stream_windows[id(volume)] = list(self.inputs[index].window_level)
+                self.streams[index].received.connect(
+                    lambda first, stop, volume=volume, stream=self.streams[index]: self._stream_received(
+                        volume, stream, first, stop
+                    )
+                )
+        self.pending -= 1
+        if self.pending == 0:
+            self._add_derived_viewers()
+
+    def _add_derived_viewers(self):
+        """Overlays, comparisons and expressions, once every input is loaded"""
+        overlays, comparisons, expressions = self.derived_specs
+
+        def available(*indices):
+            if all(self.inputs[i] is not None for i in indices):
+                return True
+            print(f"Warning: skipping {indices}, an image could not be loaded")
+            return False
+
+        # Fuse (base, overlay) volume index pairs
+        for base_index, overlay_index in overlays:
+            if available(base_index, overlay_index):
+                self.inputs[base_index].set_fusion_overlay(
+                    self.inputs[overlay_index].volume,
+                    self.input_geometries[overlay_index],
+                )
+
+        # Derived (a, b, mode) comparison viewers. Shapes are only known now,
+        # errors are reported rather than raised out of the Qt slot.
+        for a_index, b_index, mode in comparisons:
+            if available(a_index, b_index):
+                try:
+                    self.add_comparison(self.inputs[a_index], self.inputs[b_index], mode)
+                except ValueError as e:
+                    print(f"Warning: skipping comparison of {a_index} and {b_index}: {e}")
+
+        # Expression viewers, the input viewers are named a, b, c, ...
+        for expression in expressions:
+            try:
+                self.add_expression(expression)
+            except ValueError as e:
+                print(f"Warning: skipping expression {expression!r}: {e}")
+
+        if not self.viewers:
+            QTimer.singleShot(0, lambda: self.app.exit(1))
+
+    def add_viewer(self, volume, geometry=None):
+        """Open a viewer on a volume and include it in synchronization"""
+        kwargs = {"stats": self.volume_stats.get(id(volume))}
+        if kwargs["stats"] is None and id(volume) in self.stats_running:
+            # Statistics are on their way, don't scan the volume for its range meanwhile
+            if id(volume) not in self.estimated_windows:
+                self.estimated_windows[id(volume)] = sampled_range(volume)
+            kwargs["window_level"] = list(self.estimated_windows[id(volume)])
+        spec = None
+        if self.viewer_class is VolumeViewer:
+            if self.render_processes:
+                volume, spec = self.get_shared_volume(volume)
+            kwargs["roi_stats"] = self.get_roi_stats(volume)
+        viewer = self.viewer_class(
+            volume, slice_cache=self.get_slice_cache(volume), geometry=geometry, **kwargs
+        )
+        if isinstance(viewer, VolumeViewer):
+            self.memory.register(viewer.tile_cache, lambda: self._on_screen(viewer))
+        if spec is not None:
+            viewer.set_render_worker(RenderWorker(spec))
+            self.memory.register(viewer.render_worker, lambda: self._on_screen(viewer))
+        viewer.show()
+        self._connect_viewer_signals(viewer)
+        self.viewers.append(viewer)
+        return viewer
+
+    def add_comparison(self, viewer_a, viewer_b, mode="difference"):
+        """Open a viewer on the lazy difference, ratio or abserror of two viewers
+
+        Only the visible region of the displayed slice is ever computed, and
+        the viewer starts from the state of viewer_a then follows the sync.
+        """
+        volume = compare_volumes(viewer_a.volume, viewer_b.volume, mode)
+        return self._add_derived_viewer(volume, viewer_a, mode)
+
+    def _ordered_viewers(self):
+        """Input viewers in command line order (None if not loaded), then the others"""
+        return list(self.inputs) + [v for v in self.viewers if v not in self.inputs]
+
+    def add_expression(self, expression):
+        """Open a viewer on an expression of the loaded volumes, e.g. "a - b"
+
+        Variables a, b, c, ... name the input viewers in command line order,
+        then the other viewers in the order they were opened. Inputs that
+        failed to load keep their name, expressions using it are skipped
+        (None is returned).
+        """
+        named = {chr(ord("a") + i): v for i, v in enumerate(self._ordered_viewers()[:26])}
+        _, names = parse_expression(expression)
+        unavailable = [n for n in names if n in named and named[n] is None]
+        if unavailable:
+            print(f"Warning: skipping {expression!r}, image(s) {unavailable} could not be loaded")
+            return None
+        volume = ExpressionVolume(
+            expression, {name: v.volume for name, v in named.items() if v is not None}
+        )
+        return self._add_derived_viewer(volume, named[volume.names[0]], expression)
+
+    def _add_derived_viewer(self, volume, viewer_a, title):
+        viewer = self.add_viewer(volume, viewer_a.geometry)
+        viewer.setWindowTitle(f"Volume Viewer ({title})")
+        if isinstance(viewer, VolumeViewer):
+            viewer.set_orientation(viewer_a.orientation, internal=True)
+            viewer.set_slice(viewer_a.current_slice, internal=True)
+            if viewer_a.view_rect is not None:
+                viewer.set_view_rect(viewer_a.view_rect, internal=True)
+        else:
+            viewer.set_crosshair(viewer_a.crosshair, internal=True)
+        return viewer
+
+    def get_slice_cache(self, volume):
+        """Return the slice cache shared by every view of this volume object"""
+        cache = self.slice_caches.get(id(volume))
+        if cache is None:
+            cache = SliceCache(volume)
+            self.slice_caches[id(volume)] = cache
+            self.memory.add_volume(volume)
+            visible = lambda: self._volume_on_screen(volume)
+            self.memory.register(cache, visible)
+            if hasattr(volume, "evict"):  # Derived volumes cache computed regions
+                self.memory.register(volume, visible)
+        return cache
+
+    def _volume_changed(self, volume, changes):
+        """Drop the caches and statistics the changed chunks touch, re-render in place"""
+        stats = self.roi_stats.get(id(volume))
+        if stats is not None:
+            for frame, z_indices in changes.frames().items():
+                stats.update(frame, z_indices)
+        if id(volume) in self.volume_stats or id(volume) in self.stats_running:
+            self.request_stats(volume)
+
+        views = [v for v in self.viewers if v.volume is volume]
+        cache = self.slice_caches.get(id(volume))
+        for orientation in range(3):
+            indices = changes.slices(orientation)
+            if len(indices) == num_slices(volume, orientation):
+                indices = [None]  # All of them
+            for index in indices:
+                if cache is not None:
+                    cache.invalidate(orientation, index)
+                for viewer in views:
+                    if isinstance(viewer, VolumeViewer):
+                        viewer.tile_cache.invalidate(orientation, index)
+                        if viewer.render_worker is not None:
+                            viewer.render_worker.invalidate(orientation, index)
+
+        # Derived volumes computed from this one, and viewers fusing it
+        derived = [
+            v for v in self.viewers
+            if any(i is volume for i in getattr(v.volume, "inputs", ()))
+        ]
+        for viewer in derived:
+            viewer.volume.invalidate()
+            if id(viewer.volume) in self.roi_stats:
+                self.roi_stats[id(viewer.volume)].invalidate()
+            if isinstance(viewer, VolumeViewer):
+                viewer.tile_cache.clear()
+        fusing = [v for v in self.viewers if getattr(v, "overlay", None) is volume]
+
+        for viewer in self.viewers:
+            if viewer in views or viewer in derived or viewer in fusing:
+                viewer.refresh_data()
+
+    def _stream_received(self, volume, stream, first, stop):
+        """Show newly streamed slices: follow the newest one and widen the window
+
+        Viewers the user moved to another slice, or gave another window, are
+        left alone. Each viewer renders once, from the refresh of the changed
+        slices; statistics are computed once the stream is complete.
+        """
+        views = [v for v in self.viewers if v.volume is volume]
+        window = self.stream_windows.get(id(volume))
+        if stream.range is not None and window is not None:
+            for viewer in views:
+                if [float(v) for v in viewer.window_level] == window:
+                    viewer.set_window_level(*stream.range, internal=True, render=False)
+            self.stream_windows[id(volume)] = list(stream.range)
+        if volume.ndim == 3:
+            for viewer in views:
+                if isinstance(viewer, VolumeViewer) and viewer.orientation == 0:
+                    if viewer.current_slice == max(first - 1, 0):
+                        viewer.set_slice(stop - 1, internal=True, render=False)
+
+        changed = np.zeros((int(np.prod(volume.shape[:-2])), 1), dtype=bool)
+        changed[first:stop] = True
+        self._volume_changed(volume, VolumeChanges(volume.shape, changed, volume.shape[-2]))
+        if stream.complete:
+            self.request_stats(volume)
+
+    def load_stats(self, volume, filename, options=None):
+        """Use the statistics sidecar of a file, or compute it in the background
+
+        A sidecar matching the file path, size and mtime spares the scan of
+        the whole volume for its range. Otherwise the viewer scans as before
+        and the statistics are computed and saved for the next open.
+        """
+        self.stats_sources[id(volume)] = (filename, options)
+        stats = load_sidecar(filename, volume.shape, options)
+        if stats is None:
+            self.request_stats(volume)
+        else:
+            self.volume_stats[id(volume)] = stats
+
+    def request_stats(self, volume):
+        """(Re)compute the statistics of a volume in the background"""
+        if id(volume) in self.stats_running:
+            self.stats_running[id(volume)] = True
+            return
+        self.stats_running[id(volume)] = False
+        source = self.stats_sources.get(id(volume))
+
+        def compute():
+            key = source_key(*source) if source is not None else None
+            stats = compute_stats(volume)
+            if source is not None:
+                save_sidecar(source[0], volume.shape, stats, source[1], key)
+            return stats
+
+        future = self.stats_executor.submit(compute)
+        future.add_done_callback(lambda f: self.load_notifier.stats_finished.emit(volume, f))
+
+    def _stats_finished(self, volume, future):
+        if self.stats_running.pop(id(volume)):
+            self.request_stats(volume)
+            return
+        try:
+            stats = future.result()
+        except Exception as e:
+            print(f"Warning: could not compute the statistics of a volume: {e}")
+            return
+        self.volume_stats[id(volume)] = stats
+        estimated = self.estimated_windows.pop(id(volume), None)
+        shared = self.shared_volumes.get(id(volume), (volume,))[0]
+        for viewer in self.viewers:
+            if viewer.volume is volume or viewer.volume is shared:
+                viewer.set_stats(stats)
+                if estimated is not None and list(viewer.window_level) == estimated:
+                    # Still the sampled window, the user did not change it
+                    viewer.set_window_level(*stats_range(stats), internal=True)
+
+    def get_shared_volume(self, volume):
+        """(volume, spec) of this volume placed once in shared memory, see loading.share_volume"""
+        shared = self.shared_volumes.get(id(volume))
+        if shared is None:
+            shared = share_volume(volume)
+            self.shared_volumes[id(volume)] = self.shared_volumes[id(shared[0])] = shared
+        return shared
+
+    def _viewer_closed(self, viewer):
+        """Stop syncing a closed viewer, release what only it used"""
+        if viewer in self.viewers:
+            self.viewers.remove(viewer)
+        if isinstance(viewer, VolumeViewer):
+            self.memory.unregister(viewer.tile_cache)
+        volume = viewer.volume
+        if not any(v.volume is volume for v in self.viewers):
+            stats = self.roi_stats.pop(id(volume), None)
+            if stats is not None:
+                self.memory.unregister(stats)
+                stats.shutdown()
+            cache = self.slice_caches.pop(id(volume), None)
+            if cache is not None:
+                self.memory.unregister(cache)
+            if hasattr(volume, "evict"):
+                self.memory.unregister(volume)
+        # Volumes no viewer shows, computes from or fuses any more are let go
+        for candidate in [volume, getattr(viewer, "overlay", None), *getattr(volume, "inputs", ())]:
+            if candidate is not None and not self._volume_in_use(candidate):
+                self._release_volume(candidate)
+
+    def _volume_in_use(self, volume):
+        return any(
+            v.volume is volume
+            or getattr(v, "overlay", None) is volume
+            or any(i is volume for i in getattr(v.volume, "inputs", ()))
+            for v in self.viewers
+        )
+
+    def _release_volume(self, volume):
+        """Forget a volume no viewer uses, so its memory can be freed"""
+        self.memory.remove_volume(volume)
+        if self.watcher is not None:
+            self.watcher.unwatch(volume)
+        # Keyed by id (of the volume, or of the array it was shared from), which a later volume may reuse
+        keys = {id(volume)} | {k for k, (shared, _) in self.shared_volumes.items() if shared is volume}
+        for key in keys:
+            for table in (self.shared_volumes, self.volume_stats, self.stats_sources, self.estimated_windows):
+                table.pop(key, None)
+
+    def get_roi_stats(self, volume):
+        """Return the ROI statistics engine (and its block tables) of this volume"""
+        stats = self.roi_stats.get(id(volume))
+        if stats is None:
+            stats = RoiStats(volume)
+            self.roi_stats[id(volume)] = stats
+            self.memory.register(stats, lambda: self._volume_on_screen(volume))
+        return stats
+
+    @staticmethod
+    def _on_screen(viewer):
+        return viewer.isVisible() and not viewer.isMinimized()
+
+    def _volume_on_screen(self, volume):
+        return any(v.volume is volume and self._on_screen(v) for v in self.viewers)
+
+    def update_memory(self):
+        """Enforce the memory budget and show the usage in the sync controls"""
+        self.memory.trim()
+        self.sync_control.memory_label.setText(self.memory.summary())
+
+    def get_index_transform(self, source, target):
+        """Affine from source to target voxel indices, or None to sync by fraction
+
+        Only used when both viewers carry real geometry; volumes without any
+        metadata keep the relative-fraction behaviour.
+        """
+        if source.geometry.is_default or target.geometry.is_default:
+            return None
+        key = (id(source), id(target))
+        transform = self.index_transforms.get(key)
+        if transform is None:
+            transform = index_transform(source.geometry, target.geometry)
+            self.index_transforms[key] = transform
+        return transform
+
+    def _map_view_rect(self, source, target, view_rect, transform):
+        """Map a view rect through physical space onto the target's slice plane"""
+        x_min, x_max, y_min, y_max = view_rect
+        column_axis, row_axis, _ = PLANE_AXES[target.orientation]
+        corners = []
+        # View rects are in pixel-edge coordinates, voxel centers sit at +0.5
+        for column, row in ((x_min, y_min), (x_max, y_max)):
+            point = plane_point(
+                source.orientation, column - 0.5, row - 0.5, source.current_slice
+            )
+            mapped = transform[:3, :3] @ point + transform[:3, 3]
+            corners.append((float(mapped[column_axis]) + 0.5, float(mapped[row_axis]) + 0.5))
+        (c0, r0), (c1, r1) = corners
+        return (min(c0, c1), max(c0, c1), min(r0, r1), max(r0, r1))
+
+    def _map_slice(self, source, target, slice_idx, transform):
+        """Slice of the target through the center of the source's view"""
+        x_min, x_max, y_min, y_max = source.view_rect or (
+            0,
+            source.get_current_width(),
+            0,
+            source.get_current_height(),
+        )
+        point = plane_point(
+            source.orientation,
+            (x_min + x_max) / 2 - 0.5,
+            (y_min + y_max) / 2 - 0.5,
+            slice_idx,
+        )
+        mapped = transform[:3, :3] @ point + transform[:3, 3]
+        _, _, slice_axis = PLANE_AXES[target.orientation]
+        max_slice = self.get_orientation_max_slice(target)
+        return int(clamp(round(mapped[slice_axis]), 0, max_slice))
+
     def handle_sync_toggled(self, sync_type, checked):
+        if sync_type == "cursor" and not checked:
+            for viewer in self.viewers:
+                if isinstance(viewer, VolumeViewer):
+                    viewer.set_hover(None, internal=True)
         if not checked or not self.viewers:
             return
 
-        # Get reference viewer (first viewer)
-        ref_viewer = self.viewers[0]
+        # Reference viewer: the first open input in command line order
+        ref_viewer = next(v for v in self._ordered_viewers() if v in self.viewers)
 
         # Sync all viewers to reference viewer's state
+        others = [v for v in self.viewers if v is not ref_viewer]
+        if isinstance(ref_viewer, TriPlanarViewer):
+            if sync_type == "intensity":
+                wl = (ref_viewer.window_level[0], ref_viewer.window_level[1])
+                for viewer in others:
+                    viewer.set_window_level(*wl, internal=True)
+            elif sync_type == "slice":
+                for viewer in others:
+                    viewer.set_crosshair(ref_viewer.crosshair, internal=True)
+            return
+
         if sync_type == "intensity":
             wl = (ref_viewer.window_level[0], ref_viewer.window_level[1])
-            for viewer in self.viewers[1:]:
+            for viewer in others:
                 viewer.set_window_level(*wl, internal=True)
         elif sync_type == "view":
             vr = ref_viewer.view_rect
-            for viewer in self.viewers[1:]:
+            for viewer in others:
                 viewer.set_view_rect(vr, internal=True)
+        elif sync_type == "time":
+            for viewer in others:
+                viewer.set_frame(ref_viewer.current_frame, internal=True)
         elif sync_type == "slice":
             sl = ref_viewer.current_slice
-            for viewer in self.viewers[1:]:
+            for viewer in others:
                 viewer.set_orientation(ref_viewer.orientation, internal=True)
                 viewer.set_slice(sl, internal=True)
             # Then sync view rectangle and slice ??? TODO check if this makes sense
@@ -459,16 +2303,31 @@ class VolumeViewerManager:
             # self._propagate_slice(ref_viewer, ref_viewer.current_slice)
 
     def _connect_viewer_signals(self, viewer):
+        viewer.closed.connect(lambda: self._viewer_closed(viewer))
         viewer.intensity_changed.connect(
             lambda wl: self._propagate_intensity(viewer, wl)
         )
+        if isinstance(viewer, TriPlanarViewer):
+            viewer.crosshair_changed.connect(
+                lambda c: self._propagate_crosshair(viewer, c)
+            )
+            return
         viewer.view_rect_changed.connect(
             lambda vr: self._propagate_view_rect(viewer, vr)
         )
         viewer.slice_changed.connect(lambda s: self._propagate_slice(viewer, s))
+        viewer.frame_changed.connect(lambda f: self._propagate_frame(viewer, f))
+        viewer.slice_playback_toggled.connect(
+            lambda p: self._propagate_slice_playback(viewer, p)
+        )
         viewer.orientation_changed.connect(
             lambda o: self._propagate_orientation(viewer, o)
         )
+        viewer.hover_changed.connect(lambda p: self._propagate_hover(viewer, p))
+        viewer.profile_line_changed.connect(
+            lambda line: self._propagate_profile_line(viewer, line)
+        )
+        viewer.profile_updated.connect(self.update_profile_plot)
 
     def _propagate_intensity(self, source, window_level):
         if self.sync_control.intensity_sync.isChecked():
@@ -476,6 +2335,75 @@ class VolumeViewerManager:
                 if viewer != source:
                     viewer.set_window_level(*window_level, internal=True)
 
+    def _propagate_crosshair(self, source, crosshair):
+        if self.sync_control.slice_sync.isChecked():
+            for viewer in self.viewers:
+                if viewer != source:
+                    viewer.set_crosshair(crosshair, internal=True)
+
+    def _propagate_slice_playback(self, source, playing):
+        """Synced viewers prefetch along with a playing viewer, paced by it"""
+        if self.sync_control.slice_sync.isChecked():
+            for viewer in self.viewers:
+                if viewer != source and viewer.orientation == source.orientation:
+                    viewer.set_slice_playing(playing, follow=True)
+
+    def _propagate_frame(self, source, frame):
+        if self.sync_control.time_sync.isChecked():
+            for viewer in self.viewers:
+                if viewer != source:
+                    viewer.set_frame(frame, internal=True)
+
+    def _map_point(self, source, target, point):
+        """Continuous XYZ index of the same position in target, physical if possible"""
+        transform = self.get_index_transform(source, target)
+        if transform is not None:
+            return transform[:3, :3] @ point + transform[:3, 3]
+        # Same relative position, voxel centers at +0.5
+        source_shape = np.array((source.nx, source.ny, source.nz))
+        target_shape = np.array((target.nx, target.ny, target.nz))
+        return (point + 0.5) / source_shape * target_shape - 0.5
+
+    def _propagate_hover(self, source, point):
+        """Mirror the hover readout at the same physical position"""
+        if not self.sync_control.cursor_sync.isChecked():
+            return
+        for viewer in self.viewers:
+            if viewer != source and isinstance(viewer, VolumeViewer):
+                mapped = None if point is None else self._map_point(source, viewer, point)
+                viewer.set_hover(mapped, internal=True)
+
+    def _propagate_profile_line(self, source, line):
+        """Mirror a profile line so every viewer samples the same physical line"""
+        if not self.sync_control.cursor_sync.isChecked():
+            return
+        for viewer in self.viewers:
+            if viewer != source and isinstance(viewer, VolumeViewer):
+                if line is not None:
+                    mapped = tuple(self._map_point(source, viewer, p) for p in line)
+                    viewer.set_profile_line(mapped, internal=True)
+                else:
+                    viewer.set_profile_line(None, internal=True)
+
+    def update_profile_plot(self):
+        """Show the profiles of all viewers together, named a, b, c, ..."""
+        profiles = []
+        geometries = []
+        for i, viewer in enumerate(self._ordered_viewers()):
+            if viewer not in self.viewers or not isinstance(viewer, VolumeViewer):
+                continue
+            if viewer.profile is not None:
+                label = f"{chr(ord('a') + i)}: {viewer.windowTitle()}"
+                profiles.append((label, *viewer.profile))
+                geometries.append(viewer.geometry)
+        if self.profile_plot is None:
+            if not profiles:
+                return
+            self.profile_plot = ProfilePlot()
+            self.profile_plot.show()
+        unit = "voxels" if any(g.is_default for g in geometries) else "mm"
+        self.profile_plot.set_profiles(profiles, unit)
+
     def _propagate_orientation(self, source, orientation):
         """Propagate orientation changes to other viewers when view sync is on"""
         if self.sync_control.slice_sync.isChecked():
@@ -487,6 +2415,12 @@ class VolumeViewerManager:
         if self.sync_control.view_sync.isChecked():
             for viewer in self.viewers:
                 if viewer != source and viewer.orientation == source.orientation:
+                    transform = self.get_index_transform(source, viewer)
+                    if transform is not None:
+                        new_vr = self._map_view_rect(source, viewer, view_rect, transform)
+                        viewer.set_view_rect(new_vr, internal=True)
+                        continue
+
                     # Convert view rect to target viewer's coordinate system
                     target_width = viewer.get_current_width()
                     target_height = viewer.get_current_height()
@@ -509,7 +2443,16 @@ class VolumeViewerManager:
     def _propagate_slice(self, source, slice_idx):
         if self.sync_control.slice_sync.isChecked():
             for viewer in self.viewers:
-                viewer.set_slice(slice_idx, internal=True)
+                transform = None
+                if viewer != source and viewer.orientation == source.orientation:
+                    transform = self.get_index_transform(source, viewer)
+                if transform is not None:
+                    viewer.set_slice(
+                        self._map_slice(source, viewer, slice_idx, transform),
+                        internal=True,
+                    )
+                else:
+                    viewer.set_slice(slice_idx, internal=True)
 
     def get_orientation_max_slice(self, viewer):
         """Helper to get maximum slice for current orientation"""
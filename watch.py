@@ -0,0 +1,208 @@
+#!/usr/bin/env python
+import os
+import zlib
+from concurrent.futures import ThreadPoolExecutor
+import numpy as np
+from PyQt5.QtCore import QFileSystemWatcher, QObject, QTimer, pyqtSignal
+from image_loader import load_image
+from storage import QuantizedArray
+
+WATCH_CHUNK_BYTES = 1 << 17  # Bytes per checksummed chunk, a band of rows of a slice
+WATCH_SETTLE_MS = 300  # Quiet time after the last change before reloading
+
+
+def _slices(volume):
+    """The 2D slices of a volume, all leading axes (time, z) flattened"""
+    if isinstance(volume, QuantizedArray):
+        volume = volume.codes
+    return volume.reshape(-1, *volume.shape[-2:])
+
+
+def band_rows(volume):
+    row_bytes = volume.shape[-1] * np.dtype(volume.dtype).itemsize
+    return max(1, WATCH_CHUNK_BYTES // row_bytes)
+
+
+def chunk_checksums(volume, rows, executor):
+    """CRC32 of every band of rows of every slice, as (slices, bands) uint32
+
+    Each slice is copied contiguous and hashed as one task on executor.
+    """
+    slices = _slices(volume)
+    starts = range(0, slices.shape[1], rows)
+
+    def checksum(index):
+        plane = np.ascontiguousarray(slices[index])
+        return [zlib.crc32(plane[y : y + rows]) for y in starts]
+
+    return np.array(list(executor.map(checksum, range(len(slices)))), dtype=np.uint32)
+
+
+class VolumeChanges:
+    """Which chunks of a volume changed: changed[t * nz + z, band]"""
+
+    def __init__(self, shape, changed, rows):
+        self.shape = shape
+        self.changed = changed
+        self.rows = rows
+
+    def __bool__(self):
+        return bool(self.changed.any())
+
+    def frames(self):
+        """{frame: z indices changed}"""
+        nz = self.shape[-3]
+        changed_slices = np.flatnonzero(self.changed.any(axis=1))
+        frames = {}
+        for index in changed_slices:
+            frames.setdefault(int(index) // nz, []).append(int(index) % nz)
+        return frames
+
+    def slices(self, orientation):
+        """Slice indices of an orientation holding a changed voxel, in any frame"""
+        nz, ny, nx = self.shape[-3], self.shape[-2], self.shape[-1]
+        if orientation == 0:
+            return sorted({z for zs in self.frames().values() for z in zs})
+        if orientation == 1:
+            bands = np.flatnonzero(self.changed.any(axis=0))
+            return [y for b in bands for y in range(b * self.rows, min((b + 1) * self.rows, ny))]
+        return list(range(nx)) if self else []
+
+
+class WatchedVolume:
+    """A resident volume refreshed in place from the file it was loaded from"""
+
+    def __init__(self, volume, filename, format, spacing, crop=None, bin=1):
+        self.volume = volume
+        self.filename = filename
+        self.format = format
+        self.spacing = spacing
+        self.crop = crop
+        self.bin = bin
+        self.rows = band_rows(volume)
+        self.checksums = None  # Computed in the background when watching starts
+        self.signature = None  # (mtime, size) of the last load
+
+
+class VolumeWatcher(QObject):
+    """Watches image files and reports which chunks of their volumes changed
+
+    A rewrite of a watched file is reloaded (npy files are memory-mapped, so
+    only their pages are read) once writes have settled. Its chunks are
+    checksummed and compared in a background thread; the changed chunks
+    alone are then copied into the resident volume on the GUI thread, so
+    every reference to the volume sees the new data.
+    """
+
+    volume_changed = pyqtSignal(object, object)  # (volume, VolumeChanges)
+    _compared = pyqtSignal(object, object, object)  # Relays a comparison to the GUI thread
+
+    def __init__(self, parent=None):
+        super().__init__(parent)
+        self.watched = {}  # path -> WatchedVolume
+        self.executor = ThreadPoolExecutor(max_workers=os.cpu_count())
+        self.loader = ThreadPoolExecutor(max_workers=1)
+        self.watcher = QFileSystemWatcher(self)
+        self.watcher.fileChanged.connect(self._file_changed)
+        self.settle_timers = {}
+        self._compared.connect(self._apply)
+
+    def watch(self, volume, filename, format="sitk", spacing=None, crop=None, bin=1):
+        data = volume.codes if isinstance(volume, QuantizedArray) else volume
+        if not (data.flags.c_contiguous and data.flags.writeable):
+            raise ValueError(f"{filename} is refreshed in place, its volume must be writeable and C-contiguous")
+        path = os.path.abspath(filename)
+        watched = WatchedVolume(volume, path, format, spacing, crop, bin)
+        self.watched[path] = watched
+        watched.signature = self._signature(path)
+        self.loader.submit(self._initial_checksums, watched)
+        self.watcher.addPath(path)
+
+    def unwatch(self, volume):
+        """Stop refreshing a volume, e.g. once no viewer shows it"""
+        for path, watched in list(self.watched.items()):
+            if watched.volume is volume:
+                del self.watched[path]
+                self.watcher.removePath(path)
+
+    def _initial_checksums(self, watched):
+        watched.checksums = chunk_checksums(watched.volume, watched.rows, self.executor)
+
+    @staticmethod
+    def _signature(path):
+        try:
+            stat = os.stat(path)
+        except OSError:
+            return None
+        return stat.st_mtime_ns, stat.st_size
+
+    def _file_changed(self, path):
+        # Restarted on every event, fires once the writer went quiet
+        timer = self.settle_timers.get(path)
+        if timer is None:
+            timer = self.settle_timers[path] = QTimer(self)
+            timer.setSingleShot(True)
+            timer.setInterval(WATCH_SETTLE_MS)
+            timer.timeout.connect(lambda path=path: self._reload(path))
+        timer.start()
+
+    def _rewatch(self, path, retry=False):
+        """Watch a path again, files replaced by a rename drop out of the watcher
+
+        A file still missing (between the unlink and the rename of a writer)
+        is retried on a timer, and reloaded once it is back.
+        """
+        if path in self.watcher.files() or path not in self.watched:
+            return
+        if os.path.exists(path) and self.watcher.addPath(path):
+            if retry:
+                self._file_changed(path)  # Rewritten while unwatched
+            return
+        QTimer.singleShot(WATCH_SETTLE_MS, lambda: self._rewatch(path, retry=True))
+
+    def _reload(self, path):
+        watched = self.watched.get(path)
+        if watched is None:
+            return  # Unwatched meanwhile
+        self._rewatch(path)
+        signature = self._signature(path)
+        if signature is None or signature == watched.signature:
+            return
+        future = self.loader.submit(self._compare, watched)
+        future.add_done_callback(lambda f: self._compared.emit(watched, signature, f))
+
+    def _compare(self, watched):
+        data, _ = load_image(
+            watched.filename, watched.format, watched.spacing, watched.crop, watched.bin
+        )
+        if data.shape != watched.volume.shape:
+            raise ValueError(
+                f"{watched.filename} now has shape {data.shape}, not {watched.volume.shape}"
+            )
+        if isinstance(watched.volume, QuantizedArray):
+            # Compared in the stored form, values that quantize alike are unchanged
+            data = QuantizedArray(watched.volume.encode(data), watched.volume.slope, watched.volume.intercept)
+        elif data.dtype != watched.volume.dtype:
+            data = data.astype(watched.volume.dtype)
+        checksums = chunk_checksums(data, watched.rows, self.executor)
+        return data, checksums, checksums != watched.checksums
+
+    def _apply(self, watched, signature, future):
+        try:
+            data, checksums, changed = future.result()
+        except Exception as e:
+            print(f"Warning: could not reload {watched.filename}: {e}")
+            return
+        watched.signature = signature
+        watched.checksums = checksums
+        target, source = _slices(watched.volume), _slices(data)
+        for index, band in zip(*np.nonzero(changed)):
+            rows = slice(band * watched.rows, (band + 1) * watched.rows)
+            target[index, rows] = source[index, rows]
+        changes = VolumeChanges(watched.volume.shape, changed, watched.rows)
+        if changes:
+            self.volume_changed.emit(watched.volume, changes)
+
+    def shutdown(self):
+        self.loader.shutdown(wait=False)
+        self.executor.shutdown(wait=False)